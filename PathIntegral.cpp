@@ -15,15 +15,19 @@
 #define _USE_MATH_DEFINES
 
 #include "pathIntegral.hpp"
+#include "circuit.hpp"
 #include "helpers.hpp"
+#include "workPool.hpp"
+#include <unordered_map>
 using namespace std;
 
-// Global memory storage for recursive calls
+// Global memory storage for recursive calls (state and amplitude stack are per-thread for the parallel mode)
 extern int N;
 extern int startState, endState;
-extern ifstream in;
-int currState;
-complex<double> amplitudes[50];
+vector<gateOp> circuit; //pre-compiled instruction stream, indexed by gate number
+vector<int> lightCone; //lightCone[g]: qubits still modifiable by gates g and later (see lightConeMasks)
+thread_local int currState;
+thread_local vector<complex<double>> amplitudes; //amplitude stack, one entry per Hadamard level (sized from the circuit)
 //---------------------------------PATH INTEGRAL SUMMING-----------------------------------
 
 /* A recursive path-summing simulation algorithm
@@ -33,88 +37,67 @@ complex<double> amplitudes[50];
  V2: changed to DFS procedure
  V3: added out-of-reach path pruning
  V4: added QFT: controlled-U gates, complex numbers, phase accumulation
- V5: globalized variables to minimize space usage, rearranged parameters */
+ V5: globalized variables to minimize space usage, rearranged parameters
+ V6: circuit is compiled once into an instruction stream; steps index gates by number instead of re-parsing gates.txt
+ V7: per-thread recursion state, parallel mode (parallelPathIntegral)
+ V8: batched end states (batchPathIntegral)
+ V9: exact integer phase accumulation (exactPathIntegral)
+ V10: light-cone pruning: a path is cut once it differs from the end state on a qubit that no remaining gate can modify
+ V11: bounded transposition cache of subtree amplitudes (cachedPathIntegral)
+ V12: amplitude stack sized from the circuit instead of a fixed 50 levels; explicit-stack iterative engine (iterativePathIntegral)
+ V13: prefix-indexed subtrees (prefixTask) for sharded, checkpointed runs across processes (shardedPath.cpp) */
 
-void complexPathStep(streampos pos, int changesLeft, complex<double> currPhase, int currDepth){
-    char gate;
-    int control, c = -1, c1, c2, phasePow, target, oneFactor = 1;
-    
-    in.clear();
-    in.seekg(pos); //move to correct position
-    in >> control >> gate; //read control boolean and gate
-    
-    streampos currPos;
-    while (!in.eof()){
-        switch (gate){ //check the type of gate read
+void complexPathStep(int pos, int changesLeft, complex<double> currPhase, int currDepth){
+    if ((currState ^ endState) & ~lightCone[pos]){ //end state outside the light cone of the remaining gates
+        amplitudes[currDepth] = 0;
+        return;
+    }
+    int numGates = (int)circuit.size();
+    while (pos < numGates){
+        const gateOp &op = circuit[pos++];
+        switch (op.gate){ //check the type of gate
             case 'h': //Hadamard gate
             {
                 changesLeft--;
-                in >> target;
-                currPos = in.tellg();
                 //|0><+| case: amp is always +1
                 //|1><-| case: if the target qubit is a 1, amp turns negative; stays positive otherwise
-                if (((currState >> (N - target - 1)) & 1) == 1) oneFactor = -1;
+                int oneFactor = (currState & op.targetMask) ? -1 : 1;
                 
                 if (bitDiff(currState, endState) <= (changesLeft + 1)){ //is the end state reachable?
                     //travel down the 0 branch
-                    currState &= ~(1 << (N - target - 1));
-                    complexPathStep(currPos, changesLeft, 1/sqrt(2) * currPhase, currDepth + 1);
+                    currState &= ~op.targetMask;
+                    complexPathStep(pos, changesLeft, M_SQRT1_2 * currPhase, currDepth + 1);
                     amplitudes[currDepth] = amplitudes[currDepth + 1];
                     
                     //travel down the 1 branch
-                    currState |= (1 << (N - target - 1));
-                    complexPathStep(currPos, changesLeft, oneFactor/sqrt(2) * currPhase, currDepth + 1);
+                    currState |= op.targetMask;
+                    complexPathStep(pos, changesLeft, oneFactor * M_SQRT1_2 * currPhase, currDepth + 1);
                     amplitudes[currDepth] += amplitudes[currDepth + 1];
                     
                     //reset the state
-                    if (oneFactor == 1) currState &= ~(1 << (N - target - 1));
-                    else currState |= (1 << (N - target - 1));
+                    if (oneFactor == 1) currState &= ~op.targetMask;
                 } else amplitudes[currDepth] = 0; //otherwise, terminate computation prematurely
                 return;
-                break;
             }
             case 't': //Toffoli gate
             {
                 changesLeft--;
-                in >> c1 >> c2 >> target;
-                currPos = in.tellg();
-                int add = ((currState >> (N - c1 - 1)) & 1) * ((currState >> (N - c2 - 1)) & 1);
-                if (bitDiff(currState, endState) <= (changesLeft + 1)){ //is the end state reachable?
-                    currState ^= (add << (N - target - 1)); //Toffoli state
-                    complexPathStep(currPos, changesLeft, currPhase, currDepth); //Step forwards and compute
-                    currState ^= (add << (N - target - 1)); //Un-toffoli state
-                } else amplitudes[currDepth] = 0;
-                return;
-            }
-            case 'U':
-            {
-                in >> phasePow;
-                complex<double> phase = polar(1.0, 1/pow(2, phasePow) * 2 * M_PI);
-                if (control){ // controlled gate case
-                    in >> c >> target;
-                    if (((currState >> (N - c - 1)) & 1) && ((currState >> (N - target - 1)) & 1)) currPhase *= phase;
-                } else { // non-controlled gate case
-                    in >> target;
-                    if ((currState >> (N - target - 1)) & 1) currPhase *= phase;
+                if (bitDiff(currState, endState) > (changesLeft + 1)){ //is the end state still reachable?
+                    amplitudes[currDepth] = 0;
+                    return;
                 }
-                break;
+                if ((currState & op.controlMask) == op.controlMask) currState ^= op.targetMask; //Toffoli state
+                complexPathStep(pos, changesLeft, currPhase, currDepth); //Step forwards and compute
+                if ((currState & op.controlMask) == op.controlMask) currState ^= op.targetMask; //Un-toffoli state
+                return;
             }
-            case 'u':
+            case 'p': //U/u phase gates (controlled or not)
             {
-                in >> phasePow;
-                complex<double> phase = polar(1.0, -1/pow(2, phasePow) * 2 * M_PI);
-                if (control){ // controlled gate case
-                    in >> c >> target;
-                    if (((currState >> (N - c - 1)) & 1) && ((currState >> (N - target - 1)) & 1)) currPhase *= phase;
-                } else { // non-controlled gate case
-                    in >> target;
-                    if ((currState >> (N - target - 1)) & 1) currPhase *= phase;
-                }
+                if ((currState & op.controlMask) == op.controlMask) currPhase *= op.phase;
                 break;
             }
             default: break;
         }
-        in >> control >> gate;
     }
     
     if (currState == endState){ //inner product <a|C|b> is 0 unless end state |a> matches start state |b>
@@ -126,11 +109,13 @@ void pathIntegral(string gatePath, int n, int startS, int endS, int numChanges,
     cout << "Main Method: [PocketSimulator]\n" << n << " qubit simulation in progress........\n";
     currState = startS, startState = startS, endState = endS;
     N = n;
-    in = ifstream(gatePath);
+    circuit = compileCircuit(gatePath, N); //parse gates.txt once
+    lightCone = lightConeMasks(circuit);
+    amplitudes.assign(hadamardCount(circuit) + 1, 0);
     
     //initial recursive call (the "root" of the path tree)
     
-    complexPathStep(ios::beg, numChanges, 1, 0);
+    complexPathStep(0, numChanges, 1, 0);
     cout << "<" << binString(endS, N) << "|Circuit|" << binString(startS, N) << "> = " << amplitudes[0].real() << " + " << amplitudes[0].imag() << "i\n";
     
     if (showRuntime){ //Print time usage
@@ -145,3 +130,594 @@ void pathIntegral(string gatePath, int n, int startS, int endS, int numChanges,
     }
     cout << "\n";
 }
+
+//-----------------------------PARALLEL PATH INTEGRAL SUMMING------------------------------
+
+/* splitPaths: walks the first 'levels' Hadamard levels of the path tree (with the same pruning as complexPathStep) and records one pathTask per surviving prefix */
+void splitPaths(int pos, int state, int changesLeft, complex<double> phase, int levels, vector<pathTask> &tasks){
+    if ((state ^ endState) & ~lightCone[pos]) return;
+    int numGates = (int)circuit.size();
+    while (pos < numGates){
+        const gateOp &op = circuit[pos];
+        if (op.gate == 'h'){
+            if (levels == 0) break; //split depth reached: the rest of the subtree becomes a task
+            pos++, changesLeft--;
+            if (bitDiff(state, endState) > (changesLeft + 1)) return; //unreachable prefix
+            int oneFactor = (state & op.targetMask) ? -1 : 1;
+            splitPaths(pos, state & ~op.targetMask, changesLeft, M_SQRT1_2 * phase, levels - 1, tasks);
+            splitPaths(pos, state | op.targetMask, changesLeft, oneFactor * M_SQRT1_2 * phase, levels - 1, tasks);
+            return;
+        } else if (op.gate == 't'){
+            changesLeft--;
+            if (bitDiff(state, endState) > (changesLeft + 1)) return;
+            if ((state & op.controlMask) == op.controlMask) state ^= op.targetMask;
+            if ((state ^ endState) & ~lightCone[pos + 1]) return; //end state outside the light cone
+        } else if (op.gate == 'p' && (state & op.controlMask) == op.controlMask) phase *= op.phase;
+        pos++;
+    }
+    tasks.push_back({pos, state, changesLeft, phase});
+}
+
+/* prefixTask: the subtree below one prefix of the path tree, addressed by its index: the first 'levels' Hadamards take the branches given by
+ the bits of prefix (most significant bit = first Hadamard), so prefixes in increasing order follow the depth-first order of the tree.
+ Returns false if the prefix is pruned (contributes 0). */
+bool prefixTask(long long prefix, int levels, int startS, int numChanges, pathTask &task){
+    int numGates = (int)circuit.size(), pos = 0, state = startS, changesLeft = numChanges, level = 0;
+    complex<double> phase = 1;
+    if ((state ^ endState) & ~lightCone[0]) return false;
+    for (; pos < numGates; pos++){
+        const gateOp &op = circuit[pos];
+        if (op.gate == 'p'){
+            if ((state & op.controlMask) == op.controlMask) phase *= op.phase;
+            continue;
+        }
+        if (op.gate == 'h' && level == levels) break; //end of the prefix
+        changesLeft--;
+        if (bitDiff(state, endState) > (changesLeft + 1)) return false;
+        if (op.gate == 'h'){
+            if ((state & op.targetMask) && ((prefix >> (levels - 1 - level)) & 1)) phase = -phase;
+            state = ((prefix >> (levels - 1 - level)) & 1) ? state | op.targetMask : state & ~op.targetMask;
+            phase *= M_SQRT1_2;
+            level++;
+        } else if ((state & op.controlMask) == op.controlMask) state ^= op.targetMask;
+        if ((state ^ endState) & ~lightCone[pos + 1]) return false;
+    }
+    task = {pos, state, changesLeft, phase};
+    return true;
+}
+
+/* Parallel version of the path integral: the tree is split at its first few Hadamard levels into ~32 tasks per thread, which are run by a
+ work-stealing pool. Each worker explores its subtrees with complexPathStep on its own (thread_local) state and amplitude stack, so space
+ stays linear per worker; the per-worker partial amplitudes are summed at the end. numThreads <= 0 uses every hardware thread. */
+void parallelPathIntegral(string gatePath, int n, int startS, int endS, int numChanges, int numThreads, bool showRuntime){
+    struct timeval wallStart, wallEnd;
+    gettimeofday(&wallStart, NULL);
+    workPool pool(numThreads);
+    cout << "Main Method: [PocketSimulator, " << pool.size() << " threads]\n" << n << " qubit simulation in progress........\n";
+    startState = startS, endState = endS;
+    N = n;
+    circuit = compileCircuit(gatePath, N);
+    lightCone = lightConeMasks(circuit);
+    
+    int hadamards = hadamardCount(circuit), levels = 0;
+    while ((1 << levels) < 32 * pool.size() && levels < hadamards && levels < 20) levels++;
+    
+    vector<pathTask> tasks;
+    splitPaths(0, startS, numChanges, 1, levels, tasks);
+    vector<complex<double>> partial(pool.size(), 0);
+    for (const pathTask &task : tasks){
+        pool.submit([&partial, task, hadamards](int id){
+            if ((int)amplitudes.size() <= hadamards) amplitudes.resize(hadamards + 1);
+            currState = task.state;
+            complexPathStep(task.pos, task.changesLeft, task.phase, 0);
+            partial[id] += amplitudes[0];
+        });
+    }
+    pool.wait();
+    
+    complex<double> result = 0;
+    for (const complex<double> &amp : partial) result += amp;
+    cout << "<" << binString(endS, N) << "|Circuit|" << binString(startS, N) << "> = " << result.real() << " + " << result.imag() << "i\n";
+    
+    if (showRuntime){ //Print time usage (CPU time summed over all threads, and wall-clock time)
+        cout.precision(7);
+        struct rusage usage;
+        getrusage(RUSAGE_SELF, &usage);
+        gettimeofday(&wallEnd, NULL);
+        long totaluTime = (usage.ru_stime.tv_sec + usage.ru_utime.tv_sec) * 1000000 + usage.ru_stime.tv_usec + usage.ru_utime.tv_usec;
+        long wall = (wallEnd.tv_sec - wallStart.tv_sec) * 1000000 + wallEnd.tv_usec - wallStart.tv_usec;
+        cout << "Runtime: " << totaluTime / (double) 1000000 << " seconds (" << tasks.size() << " tasks, wall clock " << wall / (double) 1000000 << " seconds)\n";
+    }
+    cout << "\n";
+}
+
+//------------------------------BATCHED PATH INTEGRAL SUMMING------------------------------
+
+/* Batch mode: computes <y|C|startState> for a whole set of end states y in one traversal of the path tree.
+ The end states are stored in a bitwise trie (qubit 0 at the root). Every node of the path tree keeps a frontier: the trie subtrees that
+ may still hold a reachable end state. A changing gate refines its parent's frontier one trie level down, dropping subtrees that are out of
+ reach of the remaining changing gates, and the path is pruned only once the frontier is empty (no end state in the batch is reachable).
+ Every surviving path is walked once for the whole batch; at its leaf the trie tells which end state (if any) it landed on. */
+
+struct trieNode {
+    int child[2]; //-1 if absent
+    int target; //leaves: index of the end state in the batch
+    int andMask, orMask; //AND and OR of every end state below this node
+};
+
+vector<trieNode> endTrie;
+vector<vector<int>> frontiers; //frontiers[d]: reachable trie subtrees after d changing gates on the current path
+vector<complex<double>> batchAmplitudes;
+
+/* trieInReach: the lower bound on the distance from state to every end state below node (from the bits they all agree on) is <= budget,
+ and none of those agreed bits differs from state outside the light cone 'reachable' */
+bool trieInReach(int node, int state, int budget, int reachable){
+    const trieNode &t = endTrie[node];
+    int mismatch = (t.andMask & ~state) | (state & ~t.orMask);
+    return !(mismatch & ~reachable) && bitDiff(mismatch, 0) <= budget;
+}
+
+/* refineFrontier: builds the frontier after a changing gate from frontiers[level] for the given state, flip budget and light cone, and returns
+ its level (-1 if it is empty). While the budget and light cone cover every qubit nothing can be out of reach, so the parent's frontier is
+ reused as is. */
+int refineFrontier(int level, int state, int budget, int reachable){
+    if (budget >= N && reachable == (int)((1LL << N) - 1)) return level;
+    vector<int> &next = frontiers[level + 1];
+    next.clear();
+    for (int node : frontiers[level]){
+        const trieNode &t = endTrie[node];
+        if (!trieInReach(node, state, budget, reachable)) continue;
+        if (t.andMask == t.orMask) next.push_back(node); //a single end state below: the bound is exact
+        else for (int b = 0; b < 2; b++){
+            if (t.child[b] != -1 && trieInReach(t.child[b], state, budget, reachable)) next.push_back(t.child[b]);
+        }
+    }
+    return next.empty() ? -1 : level + 1;
+}
+
+/* trieFind: index of state in the batch, or -1 */
+int trieFind(int state){
+    int node = 0;
+    for (int depth = 0; depth < N && node != -1; depth++) node = endTrie[node].child[(state >> (N - depth - 1)) & 1];
+    return node == -1 ? -1 : endTrie[node].target;
+}
+
+void batchPathStep(int pos, int changesLeft, complex<double> currPhase, int level){
+    int numGates = (int)circuit.size();
+    while (pos < numGates){
+        const gateOp &op = circuit[pos++];
+        switch (op.gate){
+            case 'h': //Hadamard gate
+            {
+                changesLeft--;
+                int oneFactor = (currState & op.targetMask) ? -1 : 1;
+                int next = refineFrontier(level, currState, changesLeft + 1, lightCone[pos - 1]);
+                if (next != -1){ //is any end state reachable?
+                    currState &= ~op.targetMask;
+                    batchPathStep(pos, changesLeft, M_SQRT1_2 * currPhase, next);
+                    currState |= op.targetMask;
+                    batchPathStep(pos, changesLeft, oneFactor * M_SQRT1_2 * currPhase, next);
+                    if (oneFactor == 1) currState &= ~op.targetMask;
+                }
+                return;
+            }
+            case 't': //Toffoli gate
+            {
+                changesLeft--;
+                int next = refineFrontier(level, currState, changesLeft + 1, lightCone[pos - 1]);
+                if (next == -1) return;
+                if ((currState & op.controlMask) == op.controlMask) currState ^= op.targetMask;
+                batchPathStep(pos, changesLeft, currPhase, next);
+                if ((currState & op.controlMask) == op.controlMask) currState ^= op.targetMask;
+                return;
+            }
+            case 'p': //U/u phase gates
+            {
+                if ((currState & op.controlMask) == op.controlMask) currPhase *= op.phase;
+                break;
+            }
+            default: break;
+        }
+    }
+    int target = trieFind(currState);
+    if (target != -1) batchAmplitudes[target] += currPhase;
+}
+
+vector<complex<double>> batchPathIntegral(string gatePath, int n, int startS, vector<int> endStates, int numChanges, bool showRuntime){
+    cout << "Main Method: [PocketSimulator, batch of " << endStates.size() << " end states]\n" << n << " qubit simulation in progress........\n";
+    currState = startS, startState = startS;
+    N = n;
+    circuit = compileCircuit(gatePath, N);
+    lightCone = lightConeMasks(circuit);
+    
+    //build the end state trie (duplicate end states share a leaf)
+    endTrie.assign(1, {{-1, -1}, -1, ~0, 0});
+    vector<int> leafOf(endStates.size());
+    int numLeaves = 0;
+    for (int i = 0; i < (int)endStates.size(); i++){
+        int node = 0;
+        for (int depth = 0; depth <= N; depth++){
+            endTrie[node].andMask &= endStates[i], endTrie[node].orMask |= endStates[i];
+            if (depth == N) break;
+            int bit = (endStates[i] >> (N - depth - 1)) & 1;
+            if (endTrie[node].child[bit] == -1){
+                endTrie[node].child[bit] = (int)endTrie.size();
+                endTrie.push_back({{-1, -1}, -1, ~0, 0});
+            }
+            node = endTrie[node].child[bit];
+        }
+        if (endTrie[node].target == -1) endTrie[node].target = numLeaves++;
+        leafOf[i] = endTrie[node].target;
+    }
+    batchAmplitudes.assign(numLeaves, 0);
+    
+    int changingGates = 0;
+    for (const gateOp &op : circuit) if (op.gate != 'p') changingGates++;
+    frontiers.assign(changingGates + 1, vector<int>());
+    frontiers[0].push_back(0);
+    if (!endStates.empty()) batchPathStep(0, numChanges, 1, 0);
+    
+    vector<complex<double>> result(endStates.size());
+    for (int i = 0; i < (int)endStates.size(); i++){
+        result[i] = batchAmplitudes[leafOf[i]];
+        cout << "<" << binString(endStates[i], N) << "|Circuit|" << binString(startS, N) << "> = " << result[i].real() << " + " << result[i].imag() << "i\n";
+    }
+    
+    if (showRuntime){ //Print time usage
+        cout.precision(7);
+        struct rusage usage;
+        getrusage(RUSAGE_SELF, &usage);
+        long totaluTime = (usage.ru_stime.tv_sec + usage.ru_utime.tv_sec) * 1000000 + usage.ru_stime.tv_usec + usage.ru_utime.tv_usec;
+        double totalTime = totaluTime/ (double) 1000000;
+        cout << "Runtime: " << totalTime << " seconds\n";
+    }
+    cout << "\n";
+    return result;
+}
+
+//---------------------------EXACT (INTEGER PHASE) PATH INTEGRAL---------------------------
+
+/* Exact mode: every phase in the gate set is a multiple of 2pi/2^kmax (kmax = largest U/u power, at least 1), and every complete path
+ crosses all h Hadamards, so a path's amplitude is always 2^(-h/2) * w^e with w = e^(2pi i/2^kmax). Each path therefore only carries the
+ integer exponent e mod 2^kmax: a U/u gate adds +-2^(kmax - a) and a Hadamard's minus sign adds 2^(kmax - 1). Leaves reaching endState
+ increment an integer counter for their exponent, and the counters are converted to a complex amplitude once at the very end.
+ The inner loop is integer-only, so the path sum itself carries no rounding error. */
+
+#define DENSE_PHASE_BITS 20 //largest kmax using a dense counter array (2^20 counters); larger ones use a hash map
+
+int phaseBits; //kmax
+unsigned long long phaseMask, halfTurn; //2^kmax - 1, 2^(kmax - 1)
+vector<unsigned long long> phaseSteps; //exponent increment of each phase gate
+vector<long long> denseCounts; //path counts per phase exponent (kmax <= DENSE_PHASE_BITS)
+unordered_map<unsigned long long, long long> sparseCounts; //path counts per phase exponent (kmax > DENSE_PHASE_BITS)
+
+/* setupPhaseSteps: sets kmax and the per-gate exponent increments for the compiled circuit; false if kmax exceeds 62 bits */
+bool setupPhaseSteps(){
+    phaseBits = 1;
+    for (const gateOp &op : circuit) if (op.gate == 'p') phaseBits = max(phaseBits, op.phasePow);
+    if (phaseBits > 62) return false;
+    phaseMask = (1ULL << phaseBits) - 1, halfTurn = 1ULL << (phaseBits - 1);
+    phaseSteps.assign(circuit.size(), 0);
+    for (int g = 0; g < (int)circuit.size(); g++){
+        if (circuit[g].gate != 'p' || circuit[g].phasePow <= 0) continue; //2pi/2^a with a <= 0 is a full turn
+        unsigned long long step = 1ULL << (phaseBits - circuit[g].phasePow);
+        phaseSteps[g] = circuit[g].phaseSign == 1 ? step : (0 - step) & phaseMask;
+    }
+    return true;
+}
+
+void exactPathStep(int pos, int changesLeft, unsigned long long phaseExp){
+    if ((currState ^ endState) & ~lightCone[pos]) return; //end state outside the light cone
+    int numGates = (int)circuit.size();
+    while (pos < numGates){
+        const gateOp &op = circuit[pos++];
+        switch (op.gate){
+            case 'h': //Hadamard gate
+            {
+                changesLeft--;
+                bool wasOne = currState & op.targetMask; //|1><-| case: the 1 branch picks up a sign (half a turn)
+                if (bitDiff(currState, endState) <= (changesLeft + 1)){ //is the end state reachable?
+                    currState &= ~op.targetMask;
+                    exactPathStep(pos, changesLeft, phaseExp);
+                    currState |= op.targetMask;
+                    exactPathStep(pos, changesLeft, wasOne ? (phaseExp + halfTurn) & phaseMask : phaseExp);
+                    if (!wasOne) currState &= ~op.targetMask;
+                }
+                return;
+            }
+            case 't': //Toffoli gate
+            {
+                changesLeft--;
+                if (bitDiff(currState, endState) > (changesLeft + 1)) return;
+                if ((currState & op.controlMask) == op.controlMask) currState ^= op.targetMask;
+                exactPathStep(pos, changesLeft, phaseExp);
+                if ((currState & op.controlMask) == op.controlMask) currState ^= op.targetMask;
+                return;
+            }
+            case 'p': //U/u phase gates
+            {
+                if ((currState & op.controlMask) == op.controlMask) phaseExp = (phaseExp + phaseSteps[pos - 1]) & phaseMask;
+                break;
+            }
+            default: break;
+        }
+    }
+    if (currState == endState){
+        if (phaseBits <= DENSE_PHASE_BITS) denseCounts[phaseExp]++;
+        else sparseCounts[phaseExp]++;
+    }
+}
+
+void exactPathIntegral(string gatePath, int n, int startS, int endS, int numChanges, bool showRuntime){
+    cout << "Main Method: [PocketSimulator, exact phases]\n" << n << " qubit simulation in progress........\n";
+    currState = startS, startState = startS, endState = endS;
+    N = n;
+    circuit = compileCircuit(gatePath, N);
+    lightCone = lightConeMasks(circuit);
+    
+    int hadamards = hadamardCount(circuit);
+    if (!setupPhaseSteps()){
+        cout << "Phase powers above 62 are not supported in exact mode, using the floating-point algorithm\n";
+        pathIntegral(gatePath, N, startS, endS, numChanges, showRuntime);
+        return;
+    }
+    denseCounts.assign(phaseBits <= DENSE_PHASE_BITS ? (size_t)1 << phaseBits : 0, 0);
+    sparseCounts.clear();
+    
+    exactPathStep(0, numChanges, 0);
+    
+    //fold opposite phases together (w^(e + 2^(kmax - 1)) = -w^e), then convert the integer counts once
+    unordered_map<unsigned long long, long long> folded;
+    if (phaseBits <= DENSE_PHASE_BITS){
+        for (unsigned long long e = 0; e < halfTurn; e++){
+            long long count = denseCounts[e] - denseCounts[e + halfTurn];
+            if (count != 0) folded[e] = count;
+        }
+    } else {
+        for (const pair<const unsigned long long, long long> &term : sparseCounts) folded[term.first & (halfTurn - 1)] += (term.first & halfTurn) ? -term.second : term.second;
+    }
+    complex<long double> sum = 0;
+    int terms = 0;
+    for (const pair<const unsigned long long, long long> &term : folded){
+        if (term.second == 0) continue;
+        sum += (long double)term.second * polar((long double)1, 2 * (long double)M_PI * term.first / (long double)(1ULL << phaseBits));
+        terms++;
+    }
+    complex<double> result = complex<double>(sum * powl(2, -hadamards/(long double)2));
+    cout << "<" << binString(endS, N) << "|Circuit|" << binString(startS, N) << "> = " << result.real() << " + " << result.imag() << "i\n";
+    cout << "Exact form: 2^(-" << hadamards << "/2) * (sum of " << terms << " integer multiples of 2^" << phaseBits << "th roots of unity)\n";
+    
+    if (showRuntime){ //Print time usage
+        cout.precision(7);
+        struct rusage usage;
+        getrusage(RUSAGE_SELF, &usage);
+        long totaluTime = (usage.ru_stime.tv_sec + usage.ru_utime.tv_sec) * 1000000 + usage.ru_stime.tv_usec + usage.ru_utime.tv_usec;
+        double totalTime = totaluTime/ (double) 1000000;
+        cout << "Runtime: " << totalTime << " seconds\n";
+    }
+    cout << "\n";
+}
+
+//-----------------------------CACHED PATH INTEGRAL SUMMING--------------------------------
+
+/* Cached mode: different Hadamard branch choices often reach the same (gate index, basis state) pair, e.g. whenever a qubit is Hadamarded
+ twice, and the subtree below such a pair does not depend on how it was reached. cachedPathStep returns the phase-normalized amplitude of
+ a subtree (the amplitude when entering it with phase 1), and the amplitudes of subtrees rooted at Hadamards are memoized.
+ 
+ The memo table is a fixed-size transposition table of 4-entry buckets sized from a memory cap. When a bucket is full, the entry with the
+ fewest Hadamards left below it (the cheapest subtree to recompute) is evicted, so the cache keeps the most valuable subtrees. A cap of 0
+ gives the plain linear-space algorithm; larger caps trade memory for time. */
+
+#define CACHE_WAYS 4
+
+struct cacheEntry {
+    int pos, state; //key: gate index of the Hadamard and the state entering it (pos = -1: empty slot)
+    complex<double> amp; //phase-normalized subtree amplitude
+};
+
+vector<cacheEntry> pathCache;
+size_t cacheBuckets;
+vector<int> changesAfter, hadamardsAfter; //# of changing gates / Hadamards at gate index g or later
+long long cacheHits, cacheMisses;
+
+void countSuffixes(){ //fills changesAfter and hadamardsAfter for the compiled circuit
+    int numGates = (int)circuit.size();
+    changesAfter.assign(numGates + 1, 0), hadamardsAfter.assign(numGates + 1, 0);
+    for (int g = numGates - 1; g >= 0; g--){
+        changesAfter[g] = changesAfter[g + 1] + (circuit[g].gate != 'p');
+        hadamardsAfter[g] = hadamardsAfter[g + 1] + (circuit[g].gate == 'h');
+    }
+}
+
+cacheEntry *cacheBucket(int pos, int state){
+    unsigned long long key = ((unsigned long long)pos << 32) | (unsigned int)state;
+    key *= 0x9E3779B97F4A7C15ULL; //Fibonacci hashing
+    return &pathCache[(key >> 20) % cacheBuckets * CACHE_WAYS];
+}
+
+complex<double> cachedPathStep(int pos){
+    if ((currState ^ endState) & ~lightCone[pos]) return 0; //end state outside the light cone
+    int numGates = (int)circuit.size(), entryState = currState;
+    complex<double> currPhase = 1, result = 0;
+    for (; pos < numGates; pos++){
+        const gateOp &op = circuit[pos];
+        if (op.gate == 'p'){
+            if ((currState & op.controlMask) == op.controlMask) currPhase *= op.phase;
+            continue;
+        }
+        if (bitDiff(currState, endState) > changesAfter[pos]){ //is the end state reachable?
+            currState = entryState;
+            return 0;
+        }
+        if (op.gate == 't'){
+            if ((currState & op.controlMask) == op.controlMask) currState ^= op.targetMask;
+            if ((currState ^ endState) & ~lightCone[pos + 1]) break;
+            continue;
+        }
+        //Hadamard: look the subtree up before expanding it
+        cacheEntry *bucket = cacheBuckets ? cacheBucket(pos, currState) : NULL;
+        for (int i = 0; bucket && i < CACHE_WAYS; i++){
+            if (bucket[i].pos == pos && bucket[i].state == currState){
+                cacheHits++;
+                result = currPhase * bucket[i].amp;
+                currState = entryState;
+                return result;
+            }
+        }
+        cacheMisses++;
+        int key = currState, oneFactor = (currState & op.targetMask) ? -1 : 1;
+        currState &= ~op.targetMask;
+        complex<double> subtree = cachedPathStep(pos + 1);
+        currState |= op.targetMask;
+        subtree = M_SQRT1_2 * (subtree + (double)oneFactor * cachedPathStep(pos + 1));
+        if (bucket){ //store, evicting the entry with the fewest Hadamards below it
+            cacheEntry *slot = &bucket[0];
+            for (int i = 0; i < CACHE_WAYS && slot->pos != -1; i++){
+                if (bucket[i].pos == -1 || hadamardsAfter[bucket[i].pos] < hadamardsAfter[slot->pos]) slot = &bucket[i];
+            }
+            *slot = {pos, key, subtree};
+        }
+        currState = entryState;
+        return currPhase * subtree;
+    }
+    if (currState == endState) result = currPhase; //<a|C|b> is 0 unless the path ends in the end state
+    currState = entryState;
+    return result;
+}
+
+void cachedPathIntegral(string gatePath, int n, int startS, int endS, long long cacheBytes, bool showRuntime){
+    cout << "Main Method: [PocketSimulator, " << cacheBytes / (1 << 20) << " mb path cache]\n" << n << " qubit simulation in progress........\n";
+    currState = startS, startState = startS, endState = endS;
+    N = n;
+    circuit = compileCircuit(gatePath, N);
+    lightCone = lightConeMasks(circuit);
+    
+    countSuffixes();
+    cacheBuckets = (size_t)max(0LL, cacheBytes) / (sizeof(cacheEntry) * CACHE_WAYS);
+    pathCache.assign(cacheBuckets * CACHE_WAYS, {-1, 0, 0});
+    cacheHits = 0, cacheMisses = 0;
+    
+    complex<double> result = cachedPathStep(0);
+    cout << "<" << binString(endS, N) << "|Circuit|" << binString(startS, N) << "> = " << result.real() << " + " << result.imag() << "i\n";
+    
+    if (showRuntime){ //Print time usage
+        cout.precision(7);
+        struct rusage usage;
+        getrusage(RUSAGE_SELF, &usage);
+        long totaluTime = (usage.ru_stime.tv_sec + usage.ru_utime.tv_sec) * 1000000 + usage.ru_stime.tv_usec + usage.ru_utime.tv_usec;
+        double totalTime = totaluTime/ (double) 1000000;
+        cout << "Runtime: " << totalTime << " seconds (" << cacheHits << " cache hits, " << cacheMisses << " misses)\n";
+    }
+    cout << "\n";
+    pathCache = vector<cacheEntry>(); //release the cache
+}
+
+//----------------------------ITERATIVE PATH INTEGRAL SUMMING------------------------------
+
+/* Iterative mode: the same depth-first path sum as complexPathStep, without recursion. Walking a path, every Hadamard continues down its
+ 0 branch and pushes a compact frame (gate index, state with the target bit set, phase) for its 1 branch; a frame is popped whenever a path
+ ends or is pruned. Paths add straight into one accumulator, so there is no per-level amplitude stack, and the frame stack holds at most
+ one frame per Hadamard: it is sized from the circuit, so any branching depth is supported in O(h) space. */
+
+template <typename S>
+complex<double> iterativePathSum(const vector<basicGateOp<S>> &circuit, const vector<S> &lightCone, const vector<int> &changesAfter, S startS, S endS, long long &nodes){
+    int numGates = (int)circuit.size();
+    S zero = S(0);
+    vector<basicPathFrame<S>> stack(hadamardCount(circuit) + 1);
+    int top = 0;
+    stack[top++] = {0, startS, 1};
+    complex<double> sum = 0;
+    nodes = 0;
+    while (top > 0){
+        basicPathFrame<S> frame = stack[--top];
+        int pos = frame.pos;
+        S state = frame.state;
+        complex<double> phase = frame.phase;
+        bool reachable = ((state ^ endS) & ~lightCone[pos]) == zero;
+        for (; reachable && pos < numGates; pos++){
+            const basicGateOp<S> &op = circuit[pos];
+            if (op.gate == 'p'){
+                if ((state & op.controlMask) == op.controlMask) phase *= op.phase;
+                continue;
+            }
+            nodes++;
+            if (bitDiff(state, endS) > changesAfter[pos]){ //is the end state reachable?
+                reachable = false;
+                break;
+            }
+            if (op.gate == 'h'){ //push the 1 branch, continue down the 0 branch
+                stack[top++] = {pos + 1, state | op.targetMask, ((state & op.targetMask) != zero ? -M_SQRT1_2 : M_SQRT1_2) * phase};
+                state &= ~op.targetMask;
+                phase *= M_SQRT1_2;
+            } else if ((state & op.controlMask) == op.controlMask) state ^= op.targetMask; //Toffoli
+            reachable = ((state ^ endS) & ~lightCone[pos + 1]) == zero;
+        }
+        if (reachable && state == endS) sum += phase;
+    }
+    return sum;
+}
+
+template complex<double> iterativePathSum<int>(const vector<gateOp> &circuit, const vector<int> &lightCone, const vector<int> &changesAfter, int startS, int endS, long long &nodes);
+template complex<double> iterativePathSum<unsigned long long>(const vector<basicGateOp<unsigned long long>> &circuit, const vector<unsigned long long> &lightCone,
+                                                              const vector<int> &changesAfter, unsigned long long startS, unsigned long long endS, long long &nodes);
+template complex<double> iterativePathSum<__uint128_t>(const vector<basicGateOp<__uint128_t>> &circuit, const vector<__uint128_t> &lightCone,
+                                                       const vector<int> &changesAfter, __uint128_t startS, __uint128_t endS, long long &nodes);
+template complex<double> iterativePathSum<wideState>(const vector<basicGateOp<wideState>> &circuit, const vector<wideState> &lightCone,
+                                                     const vector<int> &changesAfter, wideState startS, wideState endS, long long &nodes);
+
+void iterativePathIntegral(string gatePath, int n, int startS, int endS, bool showRuntime){
+    cout << "Main Method: [PocketSimulator, iterative]\n" << n << " qubit simulation in progress........\n";
+    startState = startS, endState = endS;
+    N = n;
+    circuit = compileCircuit(gatePath, N);
+    lightCone = lightConeMasks(circuit);
+    
+    countSuffixes();
+    long long nodes;
+    complex<double> result = iterativePathSum(circuit, lightCone, changesAfter, startS, endS, nodes);
+    cout << "<" << binString(endS, N) << "|Circuit|" << binString(startS, N) << "> = " << result.real() << " + " << result.imag() << "i\n";
+    
+    if (showRuntime){ //Print time usage
+        cout.precision(7);
+        struct rusage usage;
+        getrusage(RUSAGE_SELF, &usage);
+        long totaluTime = (usage.ru_stime.tv_sec + usage.ru_utime.tv_sec) * 1000000 + usage.ru_stime.tv_usec + usage.ru_utime.tv_usec;
+        double totalTime = totaluTime/ (double) 1000000;
+        cout << "Runtime: " << totalTime << " seconds (" << nodes << " nodes)\n";
+    }
+    cout << "\n";
+}
+
+/* benchmarkPathEngines: runs the recursive (complexPathStep) and iterative engines on the same circuit and prints nodes/second for each.
+ Nodes are Hadamard/Toffoli visits on unpruned paths; both engines prune identically, so they visit the same nodes. */
+void benchmarkPathEngines(string gatePath, int n, int startS, int endS, int repeats){
+    cout << "Benchmark: [recursive vs iterative PocketSimulator]\n";
+    startState = startS, endState = endS;
+    N = n;
+    circuit = compileCircuit(gatePath, N);
+    lightCone = lightConeMasks(circuit);
+    amplitudes.assign(hadamardCount(circuit) + 1, 0);
+    int changingGates = 0;
+    for (const gateOp &op : circuit) if (op.gate != 'p') changingGates++;
+    
+    long long nodes = 0;
+    complex<double> recursive = 0, iterative = 0;
+    struct timeval t0, t1, t2;
+    gettimeofday(&t0, NULL);
+    for (int r = 0; r < repeats; r++){
+        currState = startS;
+        complexPathStep(0, changingGates, 1, 0);
+        recursive = amplitudes[0];
+    }
+    gettimeofday(&t1, NULL);
+    countSuffixes();
+    for (int r = 0; r < repeats; r++) iterative = iterativePathSum(circuit, lightCone, changesAfter, startS, endS, nodes);
+    gettimeofday(&t2, NULL);
+    
+    double recursiveTime = (t1.tv_sec - t0.tv_sec) + (t1.tv_usec - t0.tv_usec) / (double) 1000000;
+    double iterativeTime = (t2.tv_sec - t1.tv_sec) + (t2.tv_usec - t1.tv_usec) / (double) 1000000;
+    cout.precision(7);
+    cout << "Recursive: " << recursive.real() << " + " << recursive.imag() << "i, " << nodes * repeats / recursiveTime << " nodes/second\n";
+    cout << "Iterative: " << iterative.real() << " + " << iterative.imag() << "i, " << nodes * repeats / iterativeTime << " nodes/second\n";
+    cout << "(" << nodes << " nodes per run, " << repeats << " runs each)\n\n";
+}
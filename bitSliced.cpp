@@ -0,0 +1,222 @@
+//
+//  bitSliced.cpp
+//  PocketSimulator
+//
+//  Created on 10/16/26.
+//  Copyright © 2017. All rights reserved.
+//
+#include <iostream>
+#include <complex>
+#include <fstream>
+#include <time.h>
+#include <sys/time.h>
+#include <sys/resource.h>
+#include <math.h>
+#define _USE_MATH_DEFINES
+#if (defined(__x86_64__) || defined(__i386__)) && defined(__linux__) && defined(__GNUC__) && !defined(__clang__)
+#define SLICE_CLONES __attribute__((target_clones("avx512f", "avx2", "default"), optimize("O3"))) //one copy per ISA, picked at load time (ifunc); O3 so the 4-word loops vectorize under -O2
+#else
+#define SLICE_CLONES
+#endif
+
+#include "bitSliced.hpp"
+#include "pathIntegral.hpp"
+#include "circuit.hpp"
+#include "helpers.hpp"
+using namespace std;
+
+//BIT-SLICING VARIABLES
+#define SLICE_WORDS 4 //64-path words per slice: 4 words = 256 sibling paths (one 256-bit register in the AVX2/AVX-512 clones of sliceKernel)
+#define SLICE_LEVELS 8 //branching Hadamard levels handled by the kernel: log2(64 * SLICE_WORDS)
+typedef unsigned long long sliceWord;
+
+extern int N;
+extern int startState, endState;
+extern thread_local int currState;
+extern vector<gateOp> circuit;
+extern vector<int> lightCone, changesAfter, hadamardsAfter;
+extern int phaseBits; //exact-phase settings shared with exactPathIntegral
+extern vector<unsigned long long> phaseSteps;
+bool setupPhaseSteps();
+void countSuffixes();
+vector<int> branchingAfter; //# of Hadamards at gate index g or later whose target is still in the light cone after them
+vector<complex<double>> rootsOfUnity; //w^e for every phase exponent e (kmax <= 16)
+long long slicedLeaves;
+
+//---------------------------BIT-SLICED PATH INTEGRAL SUMMING------------------------------
+
+/* The classical part of a path is pure bit logic, so the last SLICE_LEVELS branching Hadamard levels of the path tree are evaluated for all of their
+ sibling paths at once. Only branching Hadamards need lanes: when a Hadamard's target is outside the light cone of the gates after it,
+ its branch must equal the end state's bit and the other one is pruned. Path (lane) l takes branch ((l >> j) & 1) at the j-th remaining
+ branching Hadamard, and every qubit becomes a row of SLICE_WORDS machine words holding its value in each lane:
+ 
+ Hadamard on t: the lane's sign flips where the old and new bits are both 1; q[t] = the level's branch pattern (or the end state's bit)
+ Toffoli: q[t] ^= q[c1] & q[c2]
+ U/u: the lane's phase exponent (see exactPathIntegral) gains the gate's step in the lanes where the gate fires; the exponents are stored
+ bit-sliced as well (one row per exponent bit), so this is a masked ripple-carry add
+ end: lanes matching endState = AND over qubits of ~(q[i] ^ endState_i)
+ 
+ When no phase gate fired below the split point the lane amplitudes are just +-1 and the subtree sum is two masked popcounts; otherwise
+ each matching lane's exponent is read out. Lanes are also dropped as soon as a Hadamard/Toffoli target leaves the light cone. The top of
+ the tree is walked as in iterativePathIntegral. */
+
+sliceWord slicePattern(int level, int w){ //branch taken at the level'th remaining Hadamard, for the 64 lanes of word w
+    static const sliceWord patterns[6] = {0xAAAAAAAAAAAAAAAAULL, 0xCCCCCCCCCCCCCCCCULL, 0xF0F0F0F0F0F0F0F0ULL,
+                                          0xFF00FF00FF00FF00ULL, 0xFFFF0000FFFF0000ULL, 0xFFFFFFFF00000000ULL};
+    if (level < 6) return patterns[level];
+    return ((w >> (level - 6)) & 1) ? ~0ULL : 0;
+}
+
+/* sliceKernel: phase-normalized amplitude of the subtree at gate pos from state, with at most SLICE_LEVELS branching Hadamards left.
+ As with the gate kernels (gateKernels.cpp), the word loops are compiled for AVX-512, AVX2 and the baseline, and the best the CPU
+ supports runs, without -mavx2/-mavx512f build flags. */
+SLICE_CLONES
+complex<double> sliceKernel(int pos, int state){
+    int numGates = (int)circuit.size(), levels = branchingAfter[pos], hadamards = hadamardsAfter[pos], level = 0, signRow = phaseBits - 1;
+    bool phased = false;
+    sliceWord q[32][SLICE_WORDS], e[64][SLICE_WORDS], alive[SLICE_WORDS];
+    
+    for (int i = 0; i < N; i++) for (int w = 0; w < SLICE_WORDS; w++) q[i][w] = ((state >> (N - i - 1)) & 1) ? ~0ULL : 0;
+    for (int b = 0; b < phaseBits; b++) for (int w = 0; w < SLICE_WORDS; w++) e[b][w] = 0;
+    for (int w = 0; w < SLICE_WORDS; w++){ //only the first 2^levels lanes are distinct paths
+        if (levels >= 6) alive[w] = (w < (1 << (levels - 6))) ? ~0ULL : 0;
+        else alive[w] = (w == 0) ? (1ULL << (1 << levels)) - 1 : 0;
+    }
+    
+    for (; pos < numGates; pos++){
+        const gateOp &op = circuit[pos];
+        sliceWord *t = q[op.target];
+        switch (op.gate){
+            case 'h':
+            {
+                bool branching = lightCone[pos + 1] & op.targetMask;
+                for (int w = 0; w < SLICE_WORDS; w++){
+                    sliceWord branch = branching ? slicePattern(level, w) : ((endState & op.targetMask) ? ~0ULL : 0);
+                    e[signRow][w] ^= t[w] & branch; //|1><-| case: sign flip (half a turn)
+                    t[w] = branch;
+                }
+                level += branching;
+                break;
+            }
+            case 't':
+            {
+                for (int w = 0; w < SLICE_WORDS; w++) t[w] ^= q[op.c1][w] & q[op.c2][w];
+                break;
+            }
+            case 'p':
+            {
+                sliceWord step = phaseSteps[pos];
+                if (step == 0) break;
+                phased = true;
+                int low = __builtin_ctzll(step);
+                for (int w = 0; w < SLICE_WORDS; w++){
+                    sliceWord fires = alive[w] & t[w] & (op.c1 >= 0 ? q[op.c1][w] : ~0ULL), carry = 0;
+                    for (int b = low; b < phaseBits && (fires | carry); b++){ //bit-sliced e += step where the gate fires
+                        sliceWord add = ((step >> b) & 1) ? fires : 0;
+                        sliceWord sum = e[b][w] ^ add ^ carry;
+                        carry = (e[b][w] & add) | (carry & (e[b][w] ^ add));
+                        e[b][w] = sum;
+                        if (!((step >> b) >> 1)) fires = 0; //no step bits left: only the carry propagates
+                    }
+                }
+                break;
+            }
+            default: break;
+        }
+        if (op.gate == 't' && !(lightCone[pos + 1] & op.targetMask)){ //target is final: drop lanes that disagree with endState
+            sliceWord endBit = (endState & op.targetMask) ? ~0ULL : 0, any = 0;
+            for (int w = 0; w < SLICE_WORDS; w++) alive[w] &= ~(t[w] ^ endBit), any |= alive[w];
+            if (!any) return 0;
+        }
+    }
+    
+    sliceWord match[SLICE_WORDS];
+    for (int w = 0; w < SLICE_WORDS; w++){
+        match[w] = alive[w];
+        for (int i = 0; i < N; i++) match[w] &= ~(q[i][w] ^ (((endState >> (N - i - 1)) & 1) ? ~0ULL : 0));
+    }
+    complex<double> sum = 0;
+    for (int w = 0; w < SLICE_WORDS; w++){
+        if (!phased){ //+-1 amplitudes: two masked popcounts
+            sum += __builtin_popcountll(match[w] & ~e[signRow][w]) - __builtin_popcountll(match[w] & e[signRow][w]);
+            continue;
+        }
+        for (sliceWord lanes = match[w]; lanes; lanes &= lanes - 1){
+            int lane = __builtin_ctzll(lanes);
+            unsigned long long exponent = 0;
+            for (int b = 0; b < phaseBits; b++) exponent |= ((e[b][w] >> lane) & 1) << b;
+            sum += exponent < rootsOfUnity.size() ? rootsOfUnity[exponent] : polar(1.0, 2 * M_PI * exponent / pow(2, phaseBits));
+        }
+    }
+    slicedLeaves += 1LL << levels;
+    return sum * ldexp((hadamards & 1) ? M_SQRT1_2 : 1.0, -(hadamards / 2)); //2^(-hadamards/2)
+}
+
+/* slicedPathSum: the iterative (explicit frame stack) path sum of iterativePathIntegral, handing every path to sliceKernel once it reaches a
+ point with at most SLICE_LEVELS branching Hadamards left */
+complex<double> slicedPathSum(int startS){
+    int numGates = (int)circuit.size();
+    vector<pathFrame> stack(hadamardsAfter[0] + 1);
+    int top = 0;
+    stack[top++] = {0, startS, 1};
+    complex<double> sum = 0;
+    while (top > 0){
+        pathFrame frame = stack[--top];
+        int pos = frame.pos, state = frame.state;
+        complex<double> phase = frame.phase;
+        bool reachable = !((state ^ endState) & ~lightCone[pos]);
+        for (; reachable && pos < numGates; pos++){
+            const gateOp &op = circuit[pos];
+            if (branchingAfter[pos] <= SLICE_LEVELS) break; //the rest of the subtree goes to the kernel
+            if (op.gate == 'p'){
+                if ((state & op.controlMask) == op.controlMask) phase *= op.phase;
+                continue;
+            }
+            if (bitDiff(state, endState) > changesAfter[pos]){ //is the end state reachable?
+                reachable = false;
+                break;
+            }
+            if (op.gate == 'h'){ //push the 1 branch, continue down the 0 branch
+                stack[top++] = {pos + 1, state | op.targetMask, ((state & op.targetMask) ? -M_SQRT1_2 : M_SQRT1_2) * phase};
+                state &= ~op.targetMask;
+                phase *= M_SQRT1_2;
+            } else if ((state & op.controlMask) == op.controlMask) state ^= op.targetMask; //Toffoli
+            reachable = !((state ^ endState) & ~lightCone[pos + 1]);
+        }
+        if (reachable) sum += phase * sliceKernel(pos, state);
+    }
+    return sum;
+}
+
+void bitSlicedPathIntegral(string gatePath, int n, int startS, int endS, bool showRuntime){
+    cout << "Main Method: [PocketSimulator, bit-sliced " << 64 * SLICE_WORDS << " paths]\n" << n << " qubit simulation in progress........\n";
+    currState = startS, startState = startS, endState = endS;
+    N = n;
+    circuit = compileCircuit(gatePath, N);
+    lightCone = lightConeMasks(circuit);
+    countSuffixes();
+    if (!setupPhaseSteps()){
+        cout << "Phase powers above 62 are not supported by the bit-sliced kernel, using the iterative algorithm\n";
+        iterativePathIntegral(gatePath, N, startS, endS, showRuntime);
+        return;
+    }
+    int numGates = (int)circuit.size();
+    branchingAfter.assign(numGates + 1, 0);
+    for (int g = numGates - 1; g >= 0; g--) branchingAfter[g] = branchingAfter[g + 1] + (circuit[g].gate == 'h' && (lightCone[g + 1] & circuit[g].targetMask));
+    rootsOfUnity.clear();
+    if (phaseBits <= 16) for (int e = 0; e < (1 << phaseBits); e++) rootsOfUnity.push_back(polar(1.0, 2 * M_PI * e / (1 << phaseBits)));
+    
+    slicedLeaves = 0;
+    complex<double> result = slicedPathSum(startS);
+    cout << "<" << binString(endS, N) << "|Circuit|" << binString(startS, N) << "> = " << result.real() << " + " << result.imag() << "i\n";
+    
+    if (showRuntime){ //Print time usage
+        cout.precision(7);
+        struct rusage usage;
+        getrusage(RUSAGE_SELF, &usage);
+        long totaluTime = (usage.ru_stime.tv_sec + usage.ru_utime.tv_sec) * 1000000 + usage.ru_stime.tv_usec + usage.ru_utime.tv_usec;
+        double totalTime = totaluTime/ (double) 1000000;
+        cout << "Runtime: " << totalTime << " seconds (" << slicedLeaves << " leaves evaluated in slices)\n";
+    }
+    cout << "\n";
+}
@@ -0,0 +1,19 @@
+//
+//  bitSliced.hpp
+//  PocketSimulator
+//
+//  Created on 10/16/26.
+//  Copyright © 2017. All rights reserved.
+//
+
+#ifndef bitSliced_hpp
+#define bitSliced_hpp
+
+#include <stdio.h>
+#include <string>
+using namespace std;
+
+/* bitSlicedPathIntegral: pathIntegral whose last SLICE_LEVELS branching Hadamard levels are evaluated 64 * SLICE_WORDS sibling paths at a time */
+void bitSlicedPathIntegral(string gatePath, int N, int startState, int endState, bool showRuntime);
+
+#endif /* bitSliced_hpp */
@@ -0,0 +1,120 @@
+//
+//  cacheBlocking.cpp
+//  PocketSimulator
+//
+//  Created on 10/16/26.
+//  Copyright © 2017. All rights reserved.
+//
+#include <iostream>
+#include <algorithm>
+#include <unistd.h>
+
+#include "cacheBlocking.hpp"
+#include "gateKernels.hpp"
+using namespace std;
+
+//-------------------------------------CACHE BLOCKING---------------------------------------
+
+/* A gate mixing index bit b pairs amplitudes 2^b apart, so gates on the high bits (low-numbered qubits) stride across the whole vector.
+ Any gate whose mixing bits are all below blockQubits acts within aligned blocks of 2^blockQubits amplitudes, though: a run of such gates
+ can be applied to one cache-sized block after another, and the run costs one sweep over memory instead of one per gate. Controls and
+ phases never mix amplitudes, so they are resolved per block against the block's (fixed) high bits.
+
+ When a gate mixes a high bit, the scheduler swaps that qubit with one inside the block (an explicit swap sweep), evicting the qubit
+ whose next mixing gate is furthest away, and keeps the logical --> physical layout of the bits; the final vector is left in that
+ layout rather than swapped back. Qubits on bits below SWAP_MIN_BIT are never evicted, so every swap moves whole cache lines. */
+#define DEFAULT_L2_BYTES (1LL << 20) //if the L2 size cannot be read
+#define MIN_BLOCK_QUBITS 10 //smaller blocks would make every sweep a sequence of tiny kernel calls
+#define SWAP_MIN_BIT 3 //8 doubles per 64-byte cache line
+
+int blockQubitsFor(int N, int parts, int scalarBytes){
+    long long cache = 0;
+#ifdef _SC_LEVEL2_CACHE_SIZE
+    cache = sysconf(_SC_LEVEL2_CACHE_SIZE);
+#endif
+    if (cache <= 0) cache = DEFAULT_L2_BYTES;
+    int blockQubits = 0;
+    while ((2LL << blockQubits) * 2 * (long long)scalarBytes <= cache / 2) blockQubits++; //a block's real and imaginary parts fill half the L2
+    while (blockQubits > 0 && blockQubits < N && (1LL << (N - blockQubits)) < parts) blockQubits--;
+    if (blockQubits < MIN_BLOCK_QUBITS || blockQubits >= N) return N; //a single block: gates run one sweep each
+    return blockQubits;
+}
+
+vector<int> mixingBits(const fusedGate &pass, int N){ //the logical bits a pass mixes
+    if (pass.kind == 'u') return pass.bits;
+    if (pass.kind == 'g' && pass.op.gate != 'p') return vector<int>(1, N - pass.op.target - 1);
+    return vector<int>();
+}
+
+int mapMask(int mask, const vector<int> &layout){
+    int mapped = 0;
+    for (int b = 0; b < (int)layout.size(); b++) if ((mask >> b) & 1) mapped |= 1 << layout[b];
+    return mapped;
+}
+
+long long physicalIndex(long long logical, const vector<int> &layout){
+    long long physical = 0;
+    for (int b = 0; b < (int)layout.size(); b++) if ((logical >> b) & 1) physical |= 1LL << layout[b];
+    return physical;
+}
+
+/* physicalPass: a pass on logical bits rewritten for the current layout (a fused gate's bits re-sorted, with its matrix permuted to match) */
+fusedGate physicalPass(const fusedGate &pass, const vector<int> &layout, int N){
+    fusedGate mapped = pass;
+    if (pass.kind == 'g'){
+        gateOp &op = mapped.op;
+        op.target = N - layout[N - pass.op.target - 1] - 1;
+        if (op.c1 >= 0) op.c1 = N - layout[N - pass.op.c1 - 1] - 1;
+        if (op.c2 >= 0) op.c2 = N - layout[N - pass.op.c2 - 1] - 1;
+        op.targetMask = mapMask(pass.op.targetMask, layout), op.controlMask = mapMask(pass.op.controlMask, layout);
+        return mapped;
+    }
+    int k = (int)pass.bits.size(), dim = 1 << k, position[PHASE_TABLE_QUBITS];
+    for (int b = 0; b < k; b++) mapped.bits[b] = layout[pass.bits[b]];
+    sort(mapped.bits.begin(), mapped.bits.end());
+    for (int b = 0; b < k; b++) position[b] = (int)(find(mapped.bits.begin(), mapped.bits.end(), layout[pass.bits[b]]) - mapped.bits.begin());
+    vector<int> local(dim, 0); //old local index --> new local index
+    for (int j = 0; j < dim; j++) for (int b = 0; b < k; b++) if ((j >> b) & 1) local[j] |= 1 << position[b];
+    for (int r = 0; r < dim; r++){
+        if (pass.kind != 'u'){ //a diagonal or phase table
+            mapped.re[local[r]] = pass.re[r], mapped.im[local[r]] = pass.im[r];
+            continue;
+        }
+        for (int c = 0; c < dim; c++){
+            mapped.re[local[r] * dim + local[c]] = pass.re[r * dim + c];
+            mapped.im[local[r] * dim + local[c]] = pass.im[r * dim + c];
+        }
+    }
+    return mapped;
+}
+
+vector<blockStep> scheduleBlocks(const vector<fusedGate> &passes, int N, int blockQubits, vector<int> &layout){
+    layout.resize(N);
+    vector<int> owner(N); //owner[physical bit] = the logical bit stored there
+    for (int b = 0; b < N; b++) layout[b] = owner[b] = b;
+    vector<vector<int>> uses(N); //pass indices mixing each logical bit, ascending
+    for (int i = 0; i < (int)passes.size(); i++) for (int b : mixingBits(passes[i], N)) uses[b].push_back(i);
+    vector<int> nextUse(N, 0); //position in uses[b] of the first use at or after the current pass
+
+    vector<blockStep> steps;
+    blockStep sweep = {'b', 0, 0, vector<fusedGate>()};
+    for (int i = 0; i < (int)passes.size(); i++){
+        for (int b = 0; b < N; b++) while (nextUse[b] < (int)uses[b].size() && uses[b][nextUse[b]] < i) nextUse[b]++;
+        for (int b : mixingBits(passes[i], N)){
+            if (layout[b] < blockQubits) continue;
+            int victim = -1, furthest = -1;
+            for (int v = SWAP_MIN_BIT; v < blockQubits; v++){ //Belady: evict the qubit needed last
+                int q = owner[v], next = nextUse[q] < (int)uses[q].size() ? uses[q][nextUse[q]] : (int)passes.size();
+                if (next > i && next > furthest) victim = v, furthest = next;
+            }
+            if (!sweep.passes.empty()) steps.push_back(sweep), sweep.passes.clear();
+            steps.push_back({'s', victim, layout[b], vector<fusedGate>()});
+            int q = owner[victim];
+            swap(owner[victim], owner[layout[b]]);
+            layout[q] = layout[b], layout[b] = victim;
+        }
+        sweep.passes.push_back(physicalPass(passes[i], layout, N));
+    }
+    if (!sweep.passes.empty()) steps.push_back(sweep);
+    return steps;
+}
@@ -0,0 +1,36 @@
+//
+//  cacheBlocking.hpp
+//  PocketSimulator
+//
+//  Created on 10/16/26.
+//  Copyright © 2017. All rights reserved.
+//
+
+#ifndef cacheBlocking_hpp
+#define cacheBlocking_hpp
+
+#include <stdio.h>
+#include <vector>
+#include "gateFusion.hpp"
+using namespace std;
+
+/* blockStep: one sweep over the state vector. kind 's' swaps index bits low and high (bringing a qubit into the cache block); 'b' runs
+ passes one block of 2^blockQubits amplitudes at a time. The passes of a 'b' step are on physical index bits: every bit they mix (a
+ Hadamard or Toffoli target, the bits of a dense fused gate) is below blockQubits, while controls and phases may use any bit. */
+struct blockStep {
+    char kind;
+    int low, high;
+    vector<fusedGate> passes;
+};
+
+/* blockQubitsFor: log2 of the amplitudes in a cache block (about half of the L2 cache, for real and imaginary parts of scalarBytes each),
+ capped so that each of 'parts' threads gets at least one block of an N-qubit vector */
+int blockQubitsFor(int N, int parts, int scalarBytes);
+
+/* scheduleBlocks: the sweeps that apply passes (on logical bits: qubit q --> bit N - q - 1) with every mixing bit inside the cache block,
+ swapping qubits in and out of the block as needed. layout[b] is set to the physical bit holding logical bit b at the end. */
+vector<blockStep> scheduleBlocks(const vector<fusedGate> &passes, int N, int blockQubits, vector<int> &layout);
+
+long long physicalIndex(long long logical, const vector<int> &layout); //where the amplitude of a logical index is stored
+
+#endif /* cacheBlocking_hpp */
@@ -0,0 +1,101 @@
+//
+//  circuit.cpp
+//  PocketSimulator
+//
+//  Created on 10/16/26.
+//  Copyright © 2017. All rights reserved.
+//
+#include <iostream>
+#include <complex>
+#include <fstream>
+#include <math.h>
+#define _USE_MATH_DEFINES
+
+#include "circuit.hpp"
+using namespace std;
+
+//---------------------------------CIRCUIT COMPILATION-------------------------------------
+
+/* Reads gates.txt a single time and converts every gate into a gateOp, so that the simulation engines index
+ into an array by gate number instead of seeking into and re-parsing the text file at every step. */
+
+vector<gateOp> compileCircuit(string gatePath, int N){
+    return compileWideCircuit<int>(gatePath, N);
+}
+
+template <typename S>
+vector<basicGateOp<S>> compileWideCircuit(string gatePath, int N){
+    ifstream in = ifstream(gatePath);
+    vector<basicGateOp<S>> circuit;
+    char gate;
+    int control, phasePow;
+
+    while (in >> control >> gate){
+        basicGateOp<S> op;
+        op.c1 = -1, op.c2 = -1, op.controlMask = S(0), op.phase = 1, op.phasePow = 0, op.phaseSign = 0;
+        switch (gate){
+            case 'h': //Hadamard gate
+            {
+                op.gate = 'h';
+                in >> op.target;
+                break;
+            }
+            case 't': //Toffoli gate
+            {
+                op.gate = 't';
+                in >> op.c1 >> op.c2 >> op.target;
+                op.controlMask = (S(1) << (N - op.c1 - 1)) | (S(1) << (N - op.c2 - 1));
+                break;
+            }
+            case 'U': //phase gates: U adds a phase of 2pi/2^a, u adds a phase of -2pi/2^a
+            case 'u':
+            {
+                op.gate = 'p';
+                in >> phasePow;
+                op.phasePow = phasePow, op.phaseSign = (gate == 'U' ? 1 : -1);
+                op.phase = polar(1.0, op.phaseSign/pow(2, phasePow) * 2 * M_PI);
+                if (control){ // controlled gate case
+                    in >> op.c1 >> op.target;
+                    op.controlMask = S(1) << (N - op.c1 - 1);
+                } else in >> op.target; // non-controlled gate case
+                break;
+            }
+            default:
+            {
+                cout << "Incompatible gate type: " << gate << "\n";
+                continue;
+            }
+        }
+        op.targetMask = S(1) << (N - op.target - 1);
+        if (op.gate == 'p') op.controlMask |= op.targetMask;
+        circuit.push_back(op);
+    }
+    return circuit;
+}
+
+template <typename S>
+vector<S> lightConeMasks(const vector<basicGateOp<S>> &circuit){
+    vector<S> masks(circuit.size() + 1, S(0));
+    for (int g = (int)circuit.size() - 1; g >= 0; g--){
+        masks[g] = masks[g + 1];
+        if (circuit[g].gate != 'p') masks[g] |= circuit[g].targetMask; //phase gates never change the basis state
+    }
+    return masks;
+}
+
+template <typename S>
+int hadamardCount(const vector<basicGateOp<S>> &circuit){
+    int hadamards = 0;
+    for (const basicGateOp<S> &op : circuit) if (op.gate == 'h') hadamards++;
+    return hadamards;
+}
+
+//the state types used by the engines
+#define INSTANTIATE_CIRCUIT(S) \
+    template vector<basicGateOp<S>> compileWideCircuit<S>(string gatePath, int N); \
+    template vector<S> lightConeMasks<S>(const vector<basicGateOp<S>> &circuit); \
+    template int hadamardCount<S>(const vector<basicGateOp<S>> &circuit);
+INSTANTIATE_CIRCUIT(int)
+INSTANTIATE_CIRCUIT(unsigned long long)
+INSTANTIATE_CIRCUIT(__uint128_t)
+INSTANTIATE_CIRCUIT(wideState)
@@ -0,0 +1,53 @@
+//
+//  circuit.hpp
+//  PocketSimulator
+//
+//  Created on 10/16/26.
+//  Copyright © 2017. All rights reserved.
+//
+
+#ifndef circuit_hpp
+#define circuit_hpp
+
+#include <stdio.h>
+#include <string>
+#include <vector>
+#include <complex>
+#include <bitset>
+using namespace std;
+
+#define MAX_INT_QUBITS 31 //widest register held in an int (the state type of every engine except widePathIntegral)
+#define MAX_WIDE_QUBITS 256
+typedef bitset<MAX_WIDE_QUBITS> wideState; //state type for registers wider than 128 qubits
+
+/* basicGateOp: a single pre-compiled gate of the instruction stream, for basis states of type S.
+ Qubit numbers are kept for engines that index by qubit, and are also converted once into bit masks (qubit q --> 1 << (N - q - 1)) so that
+ the simulation loops never recompute shifts. U and u gates are both compiled to a phase op carrying its precomputed phase.
+ S is int for registers of up to MAX_INT_QUBITS qubits (gateOp), and unsigned long long, __uint128_t or wideState for wider ones. */
+template <typename S>
+struct basicGateOp {
+    char gate; //'h' = Hadamard, 't' = Toffoli, 'p' = phase (U/u)
+    int target, c1, c2; //qubit numbers (c1/c2 = -1 when unused)
+    S targetMask; //bit mask of the target qubit
+    S controlMask; //Toffoli: both control bits; phase: control bit (if any) together with the target bit
+    complex<double> phase; //phase gates only: applied when (state & controlMask) == controlMask
+    int phasePow, phaseSign; //phase gates only: phase = phaseSign * 2pi/2^phasePow (phaseSign = 1 for U, -1 for u)
+};
+typedef basicGateOp<int> gateOp;
+
+/* compileCircuit: parses the gate file once into a compact instruction array for an N-qubit register.
+ Gates are stored in chronological order; unsupported gates are reported and skipped. */
+vector<gateOp> compileCircuit(string gatePath, int N);
+
+template <typename S>
+vector<basicGateOp<S>> compileWideCircuit(string gatePath, int N); //compileCircuit for the state type S
+
+template <typename S>
+int hadamardCount(const vector<basicGateOp<S>> &circuit); //# of Hadamards ("branching" gates) in the circuit
+
+/* lightConeMasks: masks[g] = the qubits that a Hadamard or Toffoli at gate index g or later can still modify (masks[circuit.size()] = 0).
+ A path at gate g whose state differs from the end state outside masks[g] can never reach it. */
+template <typename S>
+vector<S> lightConeMasks(const vector<basicGateOp<S>> &circuit);
+
+#endif /* circuit_hpp */
@@ -0,0 +1,159 @@
+//
+//  distributedVector.cpp
+//  PocketSimulator
+//
+//  Created on 10/16/26.
+//  Copyright © 2017. All rights reserved.
+//
+#include <iostream>
+#include <complex>
+#include <memory>
+#include <sys/time.h>
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <signal.h>
+#include <unistd.h>
+
+#include "distributedVector.hpp"
+#include "rankTransport.hpp"
+#include "stateVector.hpp"
+#include "gateKernels.hpp"
+#include "gateFusion.hpp"
+#include "cacheBlocking.hpp"
+#include "circuit.hpp"
+#include "helpers.hpp"
+using namespace std;
+
+//DISTRIBUTED STATE VECTOR VARIABLES
+#define MIN_LOCAL_QUBITS 10 //each rank holds at least 2^10 amplitudes, leaving room for fused gates' qubits below them
+#define EXCHANGE_CHUNK (1LL << 16) //amplitudes per exchange message: 1 MB of real and imaginary parts
+
+//------------------------------DISTRIBUTED STATE VECTOR-------------------------------------
+
+/* The 2^N amplitudes are split across P = 2^g ranks by their top g index bits (the first g qubits): rank r holds the 2^(N-g) amplitudes
+ whose index starts with r. This is the cache blocking of cacheBlocking.cpp with a rank's share as the block: scheduleBlocks turns the
+ circuit into runs of passes that only mix local bits, which every rank applies to its share without communicating, and swaps of a
+ global bit with a local one. A swap is a pairwise half-vector exchange: rank r and its partner r ^ 2^bit trade the half of their
+ amplitudes whose local bit differs from their own global bit, in chunks of EXCHANGE_CHUNK. As with cache blocking, the vector ends up
+ with its bits permuted, which is undone when the end amplitude is looked up. */
+
+/* exchangeBits: swaps local index bit 'low' with bit 'global' of the rank number */
+bool exchangeBits(double *re, double *im, long long localSize, int low, int global, rankTransport &transport, vector<double> &out, vector<double> &in){
+    int partner = transport.rank() ^ (1 << global);
+    long long theirs = ((transport.rank() >> global) & 1) ^ 1; //local amplitudes with bit low = theirs belong to the partner
+    long long half = localSize / 2, below = (1LL << low) - 1;
+    for (long long first = 0; first < half; first += EXCHANGE_CHUNK){
+        long long n = min(EXCHANGE_CHUNK, half - first);
+        for (long long j = 0; j < n; j++){
+            long long x = first + j, i = ((x >> low) << (low + 1)) | (theirs << low) | (x & below);
+            out[j] = re[i], out[n + j] = im[i];
+        }
+        if (!transport.exchange(partner, out.data(), in.data(), 2 * n * (long long)sizeof(double))) return false;
+        for (long long j = 0; j < n; j++){
+            long long x = first + j, i = ((x >> low) << (low + 1)) | (theirs << low) | (x & below);
+            re[i] = in[j], im[i] = in[n + j];
+        }
+    }
+    return true;
+}
+
+/* sumOverRanks: replaces the values by their sums over every rank, on every rank (log2(ranks) rounds of pairwise exchanges); false if
+ a rank could not be reached, in which case the values are not valid */
+bool sumOverRanks(vector<double> &values, rankTransport &transport){
+    vector<double> other(values.size());
+    for (int bit = 1; bit < transport.ranks(); bit <<= 1){
+        if (!transport.exchange(transport.rank() ^ bit, values.data(), other.data(), values.size() * (long long)sizeof(double))) return false;
+        for (int v = 0; v < (int)values.size(); v++) values[v] += other[v];
+    }
+    return true;
+}
+
+void distributedStateVector(string gatePath, int N, int startState, int endState, int fusionQubits, string transportSpec, int rank, int ranks, bool showRuntime){
+    int globalBits = 0;
+    while ((1 << globalBits) < ranks) globalBits++;
+    int localBits = N - globalBits;
+    if ((1 << globalBits) != ranks || localBits < MIN_LOCAL_QUBITS){
+        if (rank == 0) cout << "A distributed state vector needs a power of 2 ranks, each holding at least 2^" << MIN_LOCAL_QUBITS << " amplitudes\n\n";
+        return;
+    }
+    if (rank == 0) cout << "Comparison algorithm: [distributed stateVector, " << ranks << " ranks]\n" << N << " qubit simulation in progress........\n";
+    struct timeval wallStart, wallEnd;
+    gettimeofday(&wallStart, NULL);
+    unique_ptr<rankTransport> transport(openTransport(transportSpec, rank, ranks));
+    if (!transport) return;
+
+    long long localSize = 1LL << localBits, base = (long long)rank << localBits;
+    double *ampRe = allocAmplitudes<double>(localSize, false, NULL);
+    vector<double> failures(1, ampRe == NULL);
+    if (!sumOverRanks(failures, *transport) || failures[0] > 0){ //every rank stops if any could not allocate its share
+        if (rank == 0) cout << "\n";
+        free(ampRe);
+        return;
+    }
+    double *ampIm = ampRe + localSize;
+    if ((startState >> localBits) == rank) ampRe[startState - base] = 1;
+    const gateKernels &kernels = selectKernels<double>(localSize);
+    vector<fusedGate> passes = fuseGates(compileCircuit(gatePath, N), N, fusionQubits);
+    vector<int> layout; //layout[b] = the physical bit (local below localBits, rank bits above) holding index bit b
+    vector<blockStep> steps = scheduleBlocks(passes, N, localBits, layout);
+    vector<double> out(2 * min(EXCHANGE_CHUNK, localSize / 2)), in(out.size());
+    long long sweeps = 0, exchanges = 0;
+
+    for (const blockStep &step : steps){
+        if (step.kind == 's'){
+            if (!exchangeBits(ampRe, ampIm, localSize, step.low, step.high - localBits, *transport, out, in)){
+                cout << "Rank " << rank << " could not exchange amplitudes\n";
+                free(ampRe);
+                return;
+            }
+            exchanges++;
+            continue;
+        }
+        for (const fusedGate &pass : step.passes){
+            applyPass(kernels, pass, ampRe, ampIm, localSize, base, N, 0, 1);
+            sweeps++;
+        }
+    }
+
+    long long end = physicalIndex(endState, layout);
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    double cpu = usage.ru_stime.tv_sec + usage.ru_utime.tv_sec + (usage.ru_stime.tv_usec + usage.ru_utime.tv_usec) / (double) 1000000;
+    bool owner = (end >> localBits) == rank;
+    vector<double> totals = {owner ? ampRe[end - base] : 0, owner ? ampIm[end - base] : 0, cpu};
+    free(ampRe);
+    if (!sumOverRanks(totals, *transport)){
+        cout << "Rank " << rank << " could not collect the result from the other ranks\n";
+        return;
+    }
+    if (rank != 0) return;
+    cout << "<" << binString(endState, N) << "|Circuit|" << binString(startState, N) << "> = " << totals[0] << " + " << totals[1] << "i\n";
+    if (showRuntime){ //CPU time summed over all ranks
+        cout.precision(7);
+        gettimeofday(&wallEnd, NULL);
+        long wall = (wallEnd.tv_sec - wallStart.tv_sec) * 1000000 + wallEnd.tv_usec - wallStart.tv_usec;
+        cout << "Runtime: " << totals[2] << " seconds (" << ranks << " ranks over " << transport->name() << ", " << passes.size() << " passes in "
+             << sweeps << " sweeps and " << exchanges << " exchanges per rank, wall clock " << wall / (double) 1000000 << " seconds)\n";
+    }
+    cout << "\n";
+}
+
+void localDistributedStateVector(string gatePath, int N, int startState, int endState, int fusionQubits, string transportSpec, int ranks, bool showRuntime){
+    cout.flush(); //forked ranks would repeat anything still buffered
+    vector<pid_t> children;
+    for (int r = 1; r < ranks; r++){
+        pid_t pid = fork();
+        if (pid == 0){
+            distributedStateVector(gatePath, N, startState, endState, fusionQubits, transportSpec, r, ranks, showRuntime);
+            cout.flush();
+            _exit(0);
+        }
+        if (pid > 0) children.push_back(pid);
+        else cout << "Could not start rank " << r << "\n";
+    }
+    if ((int)children.size() == ranks - 1) distributedStateVector(gatePath, N, startState, endState, fusionQubits, transportSpec, 0, ranks, showRuntime);
+    for (pid_t child : children){
+        if ((int)children.size() < ranks - 1) kill(child, SIGTERM);
+        waitpid(child, NULL, 0);
+    }
+}
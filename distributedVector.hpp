@@ -0,0 +1,24 @@
+//
+//  distributedVector.hpp
+//  PocketSimulator
+//
+//  Created on 10/16/26.
+//  Copyright © 2017. All rights reserved.
+//
+
+#ifndef distributedVector_hpp
+#define distributedVector_hpp
+
+#include <stdio.h>
+#include <string>
+using namespace std;
+
+/* distributedStateVector: runs rank 'rank' of a state vector simulation split across 'ranks' processes (a power of 2), which reach each
+ other through the transport given by transportSpec (see openTransport). Every rank must be started with the same circuit and states;
+ rank 0 prints the result. */
+void distributedStateVector(string gatePath, int N, int startState, int endState, int fusionQubits, string transportSpec, int rank, int ranks, bool showRuntime);
+
+/* localDistributedStateVector: runs every rank of a distributed simulation on this host, forking one process per rank */
+void localDistributedStateVector(string gatePath, int N, int startState, int endState, int fusionQubits, string transportSpec, int ranks, bool showRuntime);
+
+#endif /* distributedVector_hpp */
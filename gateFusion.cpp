@@ -0,0 +1,211 @@
+//
+//  gateFusion.cpp
+//  PocketSimulator
+//
+//  Created on 10/16/26.
+//  Copyright © 2017. All rights reserved.
+//
+#include <iostream>
+#include <complex>
+#include <algorithm>
+#include <math.h>
+#define _USE_MATH_DEFINES
+
+#include "gateFusion.hpp"
+#include "gateKernels.hpp"
+using namespace std;
+
+//-------------------------------------GATE FUSION------------------------------------------
+
+/* Every state-vector gate is a full sweep over memory, while the arithmetic per amplitude is tiny. Consecutive gates are therefore
+ grouped greedily for as long as the qubits they touch number at most maxQubits, and each group is multiplied out into one k-qubit
+ unitary that is applied in a single sweep. A QFT, for example, fuses a Hadamard with the controlled phases to its next few qubits.
+ Groups of phase gates only stay diagonal (2^k phases instead of a 4^k matrix); a group of one gate keeps its specialized kernel.
+ 
+ A fused row has up to 2^h nonzero entries after h Hadamards (Toffolis and phases only move and scale them), and the sweep multiplies
+ every one, so a group is also closed before its rows would hold more entries than the group has gates: past that point, the fused
+ arithmetic costs more than the separate sweeps it saves. A finished group is only fused when passCost estimates the fused pass to be
+ faster than its gates one by one: a controlled phase gate's kernel visits just the amplitudes its controls select, so a QFT gains far
+ less than its count of sweeps suggests.
+ 
+ Runs of phase gates (the bulk of a QFT or a Draper adder) are taken first, on up to PHASE_TABLE_QUBITS qubits: together they are a phase
+ polynomial, sum over gates of sign * 2pi/2^a when the gate's qubits are all 1. Every phase is an integer multiple of 2pi/2^K (K the
+ largest a), so the table sums exact integers mod 2^K for each of its 2^k entries and only then takes one root of unity per entry: the
+ run costs one sweep and no per-gate polar() or rounding drift. */
+
+int gateQubits(const gateOp &op, int *qubits){ //the qubits a gate acts on
+    int count = 0;
+    qubits[count++] = op.target;
+    if (op.c1 >= 0) qubits[count++] = op.c1;
+    if (op.c2 >= 0) qubits[count++] = op.c2;
+    return count;
+}
+
+/* localMask: a global mask (qubit q --> bit N - q - 1) as a mask on the group's local bits (local bit b --> global bit bits[b]) */
+int localMask(int mask, const vector<int> &bits){
+    int local = 0;
+    for (int b = 0; b < (int)bits.size(); b++) if ((mask >> bits[b]) & 1) local |= 1 << b;
+    return local;
+}
+
+/* passCost: the time a pass takes, in Hadamard sweeps (measured on AVX-512 with the vector out of cache). A single-gate kernel only
+ visits the amplitudes its controls select (a phase gate's mask includes its target), though control bits below LINE_BITS select within
+ a cache line and so save nothing, and a pass costs PASS_COST however little it visits. A fused pass visits every amplitude: a diagonal
+ one costs DIAGONAL_COST, and a dense one adds ENTRY_COST for every nonzero entry in a row of its matrix; a phase table costs TABLE_COST. With a bit below LINE_BITS,
+ the fused kernel cannot use vector lanes and runs about SCALAR_COST times slower. */
+#define LINE_BITS 3 //8 doubles per 64-byte cache line
+#define PASS_COST 0.1
+#define DIAGONAL_COST 1.2
+#define ENTRY_COST 0.25
+#define SCALAR_COST 3
+#define TABLE_COST 1.5
+
+double passCost(const fusedGate &pass){
+    if (pass.kind == 'g') return pass.op.gate == 'h' ? 1 : PASS_COST + (1 - PASS_COST) / (1 << __builtin_popcount(pass.op.controlMask >> LINE_BITS));
+    if (pass.kind == 'z') return TABLE_COST;
+    double lanes = pass.bits[0] < LINE_BITS ? SCALAR_COST : 1;
+    if (pass.kind == 'd') return lanes * DIAGONAL_COST;
+    int dim = 1 << pass.bits.size(), widest = 0;
+    for (int r = 0; r < dim; r++){
+        int entries = 0;
+        for (int c = 0; c < dim; c++) if (pass.re[r * dim + c] != 0 || pass.im[r * dim + c] != 0) entries++;
+        widest = max(widest, entries);
+    }
+    return lanes * (1 + ENTRY_COST * widest);
+}
+
+fusedGate fuseGroup(const vector<gateOp> &circuit, int first, int last, vector<int> bits){
+    fusedGate fused;
+    fused.gates = last - first;
+    if (last - first == 1){
+        fused.kind = 'g', fused.op = circuit[first];
+        return fused;
+    }
+    sort(bits.begin(), bits.end());
+    fused.bits = bits;
+    int k = (int)bits.size(), dim = 1 << k;
+    bool diagonal = true;
+    for (int g = first; g < last; g++) if (circuit[g].gate != 'p') diagonal = false;
+    
+    if (diagonal){
+        fused.kind = 'd';
+        vector<complex<double>> d(dim, 1);
+        for (int g = first; g < last; g++){
+            int mask = localMask(circuit[g].controlMask, bits);
+            for (int j = 0; j < dim; j++) if ((j & mask) == mask) d[j] *= circuit[g].phase;
+        }
+        for (int j = 0; j < dim; j++) fused.re.push_back(d[j].real()), fused.im.push_back(d[j].imag());
+        return fused;
+    }
+    
+    fused.kind = 'u';
+    fused.re.assign(dim * dim, 0), fused.im.assign(dim * dim, 0);
+    vector<complex<double>> column(dim), next(dim);
+    for (int c = 0; c < dim; c++){ //column c = the group applied to local basis state c
+        fill(column.begin(), column.end(), 0);
+        column[c] = 1;
+        for (int g = first; g < last; g++){
+            const gateOp &op = circuit[g];
+            int target = localMask(op.targetMask, bits), controls = localMask(op.controlMask, bits);
+            switch (op.gate){
+                case 'h':
+                    for (int j = 0; j < dim; j++) if (!(j & target)){
+                        complex<double> a = column[j], b = column[j | target];
+                        column[j] = M_SQRT1_2 * (a + b), column[j | target] = M_SQRT1_2 * (a - b);
+                    }
+                    break;
+                case 't':
+                    for (int j = 0; j < dim; j++) if (!(j & target) && (j & controls) == controls) swap(column[j], column[j | target]);
+                    break;
+                case 'p':
+                    for (int j = 0; j < dim; j++) if ((j & controls) == controls) column[j] *= op.phase;
+                    break;
+                default: break;
+            }
+        }
+        for (int r = 0; r < dim; r++) fused.re[r * dim + c] = column[r].real(), fused.im[r * dim + c] = column[r].imag();
+    }
+    return fused;
+}
+
+/* phaseRun: gates [first, last) of the circuit, all phase gates, as a phase table over bits */
+fusedGate phaseRun(const vector<gateOp> &circuit, int first, int last, vector<int> bits){
+    fusedGate table;
+    table.kind = 'z', table.gates = last - first;
+    sort(bits.begin(), bits.end());
+    table.bits = bits;
+    int dim = 1 << bits.size(), K = 0;
+    for (int g = first; g < last; g++) K = max(K, circuit[g].phasePow);
+    K = min(K, 62);
+    unsigned long long modulus = (1ULL << K) - 1;
+    vector<unsigned long long> turns(dim, 0); //the phase of each entry, in units of 2pi/2^K
+    for (int g = first; g < last; g++){
+        const gateOp &op = circuit[g];
+        unsigned long long step = op.phasePow > K ? 0 : 1ULL << (K - op.phasePow); //a phase finer than 2pi/2^62 is dropped
+        if (op.phaseSign < 0) step = 0 - step;
+        int mask = localMask(op.controlMask, bits);
+        for (int j = 0; j < dim; j++) if ((j & mask) == mask) turns[j] += step;
+    }
+    for (int j = 0; j < dim; j++){
+        double angle = 2 * M_PI * (double)(turns[j] & modulus) / (double)(1ULL << K);
+        table.re.push_back(cos(angle)), table.im.push_back(sin(angle));
+    }
+    return table;
+}
+
+/* addGroup: appends gates [first, last) as one fused pass, or gate by gate when that visits fewer amplitudes */
+void addGroup(const vector<gateOp> &circuit, int first, int last, const vector<int> &bits, vector<fusedGate> &passes){
+    fusedGate fused = fuseGroup(circuit, first, last, bits);
+    double separate = 0;
+    for (int g = first; g < last && fused.kind != 'g'; g++) separate += passCost(fuseGroup(circuit, g, g + 1, bits));
+    if (fused.kind == 'g' || passCost(fused) < separate){
+        passes.push_back(fused);
+        return;
+    }
+    for (int g = first; g < last; g++) passes.push_back(fuseGroup(circuit, g, g + 1, bits));
+}
+
+vector<fusedGate> fuseGates(const vector<gateOp> &circuit, int N, int maxQubits){
+    maxQubits = min(maxQubits, MAX_FUSED_QUBITS);
+    vector<fusedGate> fused;
+    vector<int> bits; //index bits touched by the current group
+    int first = 0, hadamards = 0, qubits[3];
+    for (int g = 0; g < (int)circuit.size(); g++){
+        vector<int> run; //bits of the phase run starting at g
+        int last = g;
+        double separate = 0;
+        for (; last < (int)circuit.size() && circuit[last].gate == 'p'; last++){
+            vector<int> joined = run;
+            int count = gateQubits(circuit[last], qubits);
+            for (int i = 0; i < count; i++){
+                int bit = N - qubits[i] - 1;
+                if (find(joined.begin(), joined.end(), bit) == joined.end()) joined.push_back(bit);
+            }
+            if ((int)joined.size() > PHASE_TABLE_QUBITS) break;
+            run = joined, separate += passCost(fuseGroup(circuit, last, last + 1, run));
+        }
+        if (last - g >= 2 && separate > TABLE_COST){ //the run as one phase table, closing the group before it
+            if (first < g) addGroup(circuit, first, g, bits, fused);
+            fused.push_back(phaseRun(circuit, g, last, run));
+            first = last, bits.clear(), hadamards = 0;
+            g = last - 1;
+            continue;
+        }
+        vector<int> joined = bits;
+        int count = gateQubits(circuit[g], qubits);
+        for (int i = 0; i < count; i++){
+            int bit = N - qubits[i] - 1;
+            if (find(joined.begin(), joined.end(), bit) == joined.end()) joined.push_back(bit);
+        }
+        int h = min(hadamards + (circuit[g].gate == 'h'), 30);
+        if (g > first && ((int)joined.size() > max(maxQubits, 1) || (h > 0 && (1 << h) > g - first + 1))){ //the gate does not fit: close the group
+            addGroup(circuit, first, g, bits, fused);
+            first = g, joined.clear();
+            for (int i = 0; i < count; i++) joined.push_back(N - qubits[i] - 1);
+            h = circuit[g].gate == 'h';
+        }
+        bits = joined, hadamards = h;
+    }
+    if (first < (int)circuit.size()) addGroup(circuit, first, (int)circuit.size(), bits, fused);
+    return fused;
+}
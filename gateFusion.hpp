@@ -0,0 +1,32 @@
+//
+//  gateFusion.hpp
+//  PocketSimulator
+//
+//  Created on 10/16/26.
+//  Copyright © 2017. All rights reserved.
+//
+
+#ifndef gateFusion_hpp
+#define gateFusion_hpp
+
+#include <stdio.h>
+#include <vector>
+#include "circuit.hpp"
+using namespace std;
+
+/* fusedGate: one state-vector pass. kind 'g' is a single gate of the circuit (op), run by its own kernel; 'u' is a dense unitary and 'd'
+ a diagonal on the index bits in bits (ascending), with real/imaginary parts in re/im (see gateKernels: fused); 'z' is a run of phase
+ gates as a table of 2^k phases over up to PHASE_TABLE_QUBITS bits (see gateKernels: phaseTable). */
+struct fusedGate {
+    char kind;
+    gateOp op;
+    vector<int> bits;
+    vector<double> re, im;
+    int gates; //# of circuit gates it replaces
+};
+
+/* fuseGates: groups consecutive gates of an N-qubit circuit that together act on at most maxQubits (<= MAX_FUSED_QUBITS) qubits into
+ single passes; maxQubits <= 1 leaves every gate on its own. Runs of phase gates become phase tables whatever maxQubits is. */
+vector<fusedGate> fuseGates(const vector<gateOp> &circuit, int N, int maxQubits);
+
+#endif /* gateFusion_hpp */
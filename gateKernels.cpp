@@ -0,0 +1,829 @@
+//
+//  gateKernels.cpp
+//  PocketSimulator
+//
+//  Created on 10/16/26.
+//  Copyright © 2017. All rights reserved.
+//
+#include <iostream>
+#include <sys/time.h>
+#include <math.h>
+#include <stdlib.h>
+#include <type_traits>
+#define _USE_MATH_DEFINES
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define X86_KERNELS
+#endif
+
+#include "gateKernels.hpp"
+#include "stateVector.hpp"
+using namespace std;
+
+//-----------------------------------INDEX RUNS---------------------------------------------
+
+/* Every kernel visits the indices whose bits in some fixed mask have fixed values (e.g. controls = 1, target = 0). Those indices form runs of
+ 2^p consecutive indices, p being the lowest fixed bit, so the kernels loop over runs and stream each run with contiguous vector loads.
+ Fixed bits below the vector width cannot split a vector into runs: they are handled inside the vector, with a constant per-lane mask
+ (every run starts at a multiple of the width, so lane j always holds an index whose low bits are j). */
+
+struct runPlan {
+    long long runs, length, value;
+    int positions[64], count; //fixed bit positions, ascending
+};
+
+runPlan planRuns(long long size, long long fixedMask, long long fixedValue){
+    runPlan plan;
+    plan.count = 0, plan.value = fixedValue;
+    for (int p = 0; p < 63; p++) if ((fixedMask >> p) & 1) plan.positions[plan.count++] = p;
+    if (plan.count == 0){
+        plan.runs = 1, plan.length = size;
+        return plan;
+    }
+    plan.length = 1LL << plan.positions[0];
+    plan.runs = size >> (plan.count + plan.positions[0]);
+    return plan;
+}
+
+inline long long runStart(const runPlan &plan, long long r){ //first index of run r: r's bits with a 0 inserted at every fixed position
+    if (plan.count == 0) return 0;
+    long long x = r << plan.positions[0];
+    for (int c = 0; c < plan.count; c++){
+        int p = plan.positions[c];
+        x = ((x >> p) << (p + 1)) | (x & ((1LL << p) - 1));
+    }
+    return x | plan.value;
+}
+
+/* Multithreaded gates split the visited indices (run after run) into 'parts' equal slices of whole vectors, and slice 'part' is
+ [begin, end). spanStart maps visited index v to its amplitude index, with n = the # of consecutive indices from there (up to end). */
+inline void partRange(long long total, int width, int part, int parts, long long &begin, long long &end){
+    long long vectors = total / width;
+    begin = vectors * part / parts * width, end = vectors * (part + 1) / parts * width;
+}
+
+inline long long spanStart(const runPlan &plan, long long v, long long end, long long &n){
+    long long r = v / plan.length, offset = v - r * plan.length;
+    n = min(plan.length - offset, end - v);
+    return runStart(plan, r) + offset;
+}
+
+//-----------------------------------SCALAR KERNELS-----------------------------------------
+
+void hadamardScalar(double *re, double *im, long long size, int bit, int part, int parts){
+    long long H = 1LL << bit;
+    runPlan plan = planRuns(size, H, 0);
+    long long begin, end;
+    partRange(plan.runs * plan.length, 1, part, parts, begin, end);
+    for (long long v = begin, n; v < end; v += n){
+        long long start = spanStart(plan, v, end, n);
+        for (long long i = start; i < start + n; i++){
+            double a = re[i], b = re[i + H];
+            re[i] = M_SQRT1_2 * (a + b), re[i + H] = M_SQRT1_2 * (a - b);
+            a = im[i], b = im[i + H];
+            im[i] = M_SQRT1_2 * (a + b), im[i + H] = M_SQRT1_2 * (a - b);
+        }
+    }
+}
+
+void toffoliScalar(double *re, double *im, long long size, long long controlMask, int bit, int part, int parts){
+    long long T = 1LL << bit;
+    runPlan plan = planRuns(size, controlMask | T, controlMask);
+    long long begin, end;
+    partRange(plan.runs * plan.length, 1, part, parts, begin, end);
+    for (long long v = begin, n; v < end; v += n){
+        long long start = spanStart(plan, v, end, n);
+        for (long long i = start; i < start + n; i++){
+            swap(re[i], re[i + T]);
+            swap(im[i], im[i + T]);
+        }
+    }
+}
+
+void phaseScalar(double *re, double *im, long long size, long long mask, double c, double s, int part, int parts){
+    runPlan plan = planRuns(size, mask, mask);
+    long long begin, end;
+    partRange(plan.runs * plan.length, 1, part, parts, begin, end);
+    for (long long v = begin, n; v < end; v += n){
+        long long start = spanStart(plan, v, end, n);
+        for (long long i = start; i < start + n; i++){
+            double a = re[i], b = im[i];
+            re[i] = a * c - b * s, im[i] = a * s + b * c;
+        }
+    }
+}
+
+#ifdef X86_KERNELS
+//------------------------------------AVX2 KERNELS------------------------------------------
+
+/* 4 doubles per register. A Hadamard on bit 0 or 1 pairs lanes of the same register: with v' = v permuted so that every lane holds its
+ partner, the butterfly is v * (+1 for the 0 lane, -1 for the 1 lane) + v', scaled by 1/sqrt(2). */
+
+__attribute__((target("avx2,fma")))
+__m256d laneMask4(long long lowMask){ //all-ones in the lanes j with (j & lowMask) == lowMask
+    long long m[4];
+    for (int j = 0; j < 4; j++) m[j] = ((j & lowMask) == lowMask) ? -1 : 0;
+    return _mm256_castsi256_pd(_mm256_setr_epi64x(m[0], m[1], m[2], m[3]));
+}
+
+__attribute__((target("avx2,fma")))
+void hadamardAVX2(double *re, double *im, long long size, int bit, int part, int parts){
+    const __m256d scale = _mm256_set1_pd(M_SQRT1_2);
+    double *arrays[2] = {re, im};
+    if (bit >= 2){
+        long long H = 1LL << bit;
+        runPlan plan = planRuns(size, H, 0);
+        long long begin, end;
+        partRange(plan.runs * plan.length, 4, part, parts, begin, end);
+        for (long long v = begin, n; v < end; v += n){
+            long long start = spanStart(plan, v, end, n);
+            for (int k = 0; k < 2; k++){
+                double *x = arrays[k] + start;
+                for (long long i = 0; i < n; i += 4){
+                    __m256d a = _mm256_loadu_pd(x + i), b = _mm256_loadu_pd(x + i + H);
+                    _mm256_storeu_pd(x + i, _mm256_mul_pd(_mm256_add_pd(a, b), scale));
+                    _mm256_storeu_pd(x + i + H, _mm256_mul_pd(_mm256_sub_pd(a, b), scale));
+                }
+            }
+        }
+    } else if (bit == 1){
+        const __m256d sign = _mm256_setr_pd(1, 1, -1, -1);
+        long long begin, end;
+        partRange(size, 4, part, parts, begin, end);
+        for (int k = 0; k < 2; k++){
+            double *x = arrays[k];
+            for (long long i = begin; i < end; i += 4){
+                __m256d v = _mm256_loadu_pd(x + i), partner = _mm256_permute4x64_pd(v, 0x4E);
+                _mm256_storeu_pd(x + i, _mm256_mul_pd(_mm256_fmadd_pd(v, sign, partner), scale));
+            }
+        }
+    } else {
+        const __m256d sign = _mm256_setr_pd(1, -1, 1, -1);
+        long long begin, end;
+        partRange(size, 4, part, parts, begin, end);
+        for (int k = 0; k < 2; k++){
+            double *x = arrays[k];
+            for (long long i = begin; i < end; i += 4){
+                __m256d v = _mm256_loadu_pd(x + i), partner = _mm256_permute_pd(v, 0x5);
+                _mm256_storeu_pd(x + i, _mm256_mul_pd(_mm256_fmadd_pd(v, sign, partner), scale));
+            }
+        }
+    }
+}
+
+__attribute__((target("avx2,fma")))
+void toffoliAVX2(double *re, double *im, long long size, long long controlMask, int bit, int part, int parts){
+    long long lowControls = controlMask & 3, highControls = controlMask & ~3LL, T = 1LL << bit;
+    const __m256d lanes = laneMask4(lowControls);
+    double *arrays[2] = {re, im};
+    if (bit >= 2){ //partners in different registers: blend-swap them in the lanes whose low controls are set
+        runPlan plan = planRuns(size, highControls | T, highControls);
+        long long begin, end;
+        partRange(plan.runs * plan.length, 4, part, parts, begin, end);
+        for (long long v = begin, n; v < end; v += n){
+            long long start = spanStart(plan, v, end, n);
+            for (int k = 0; k < 2; k++){
+                double *x = arrays[k] + start;
+                for (long long i = 0; i < n; i += 4){
+                    __m256d a = _mm256_loadu_pd(x + i), b = _mm256_loadu_pd(x + i + T);
+                    _mm256_storeu_pd(x + i, _mm256_blendv_pd(a, b, lanes));
+                    _mm256_storeu_pd(x + i + T, _mm256_blendv_pd(b, a, lanes));
+                }
+            }
+        }
+    } else { //partners in the same register
+        runPlan plan = planRuns(size, highControls, highControls);
+        long long begin, end;
+        partRange(plan.runs * plan.length, 4, part, parts, begin, end);
+        for (long long v = begin, n; v < end; v += n){
+            long long start = spanStart(plan, v, end, n);
+            for (int k = 0; k < 2; k++){
+                double *x = arrays[k] + start;
+                for (long long i = 0; i < n; i += 4){
+                    __m256d v = _mm256_loadu_pd(x + i);
+                    __m256d partner = (bit == 1) ? _mm256_permute4x64_pd(v, 0x4E) : _mm256_permute_pd(v, 0x5);
+                    _mm256_storeu_pd(x + i, _mm256_blendv_pd(v, partner, lanes));
+                }
+            }
+        }
+    }
+}
+
+__attribute__((target("avx2,fma")))
+void phaseAVX2(double *re, double *im, long long size, long long mask, double c, double s, int part, int parts){
+    long long high = mask & ~3LL;
+    const __m256d lanes = laneMask4(mask & 3), cv = _mm256_set1_pd(c), sv = _mm256_set1_pd(s);
+    runPlan plan = planRuns(size, high, high);
+    long long begin, end;
+    partRange(plan.runs * plan.length, 4, part, parts, begin, end);
+    for (long long v = begin, n; v < end; v += n){
+        long long start = spanStart(plan, v, end, n);
+        for (long long i = start; i < start + n; i += 4){
+            __m256d a = _mm256_loadu_pd(re + i), b = _mm256_loadu_pd(im + i);
+            __m256d newRe = _mm256_fmsub_pd(a, cv, _mm256_mul_pd(b, sv)), newIm = _mm256_fmadd_pd(a, sv, _mm256_mul_pd(b, cv));
+            _mm256_storeu_pd(re + i, _mm256_blendv_pd(a, newRe, lanes));
+            _mm256_storeu_pd(im + i, _mm256_blendv_pd(b, newIm, lanes));
+        }
+    }
+}
+
+//-----------------------------------AVX-512 KERNELS----------------------------------------
+
+/* 8 doubles per register; in-register partners (bits 0-2) are gathered with one permutexvar (lane j <-- lane j ^ 2^bit), and lane masks
+ are k-registers. */
+
+__mmask8 laneMask8(long long lowMask){
+    __mmask8 m = 0;
+    for (int j = 0; j < 8; j++) if ((j & lowMask) == lowMask) m |= 1 << j;
+    return m;
+}
+
+__attribute__((target("avx512f")))
+void hadamardAVX512(double *re, double *im, long long size, int bit, int part, int parts){
+    const __m512d scale = _mm512_set1_pd(M_SQRT1_2);
+    double *arrays[2] = {re, im};
+    if (bit >= 3){
+        long long H = 1LL << bit;
+        runPlan plan = planRuns(size, H, 0);
+        long long begin, end;
+        partRange(plan.runs * plan.length, 8, part, parts, begin, end);
+        for (long long v = begin, n; v < end; v += n){
+            long long start = spanStart(plan, v, end, n);
+            for (int k = 0; k < 2; k++){
+                double *x = arrays[k] + start;
+                for (long long i = 0; i < n; i += 8){
+                    __m512d a = _mm512_loadu_pd(x + i), b = _mm512_loadu_pd(x + i + H);
+                    _mm512_storeu_pd(x + i, _mm512_mul_pd(_mm512_add_pd(a, b), scale));
+                    _mm512_storeu_pd(x + i + H, _mm512_mul_pd(_mm512_sub_pd(a, b), scale));
+                }
+            }
+        }
+    } else {
+        int h = 1 << bit;
+        const __m512i partners = _mm512_setr_epi64(0 ^ h, 1 ^ h, 2 ^ h, 3 ^ h, 4 ^ h, 5 ^ h, 6 ^ h, 7 ^ h);
+        const __m512d sign = _mm512_setr_pd((0 & h) ? -1 : 1, (1 & h) ? -1 : 1, (2 & h) ? -1 : 1, (3 & h) ? -1 : 1,
+                                            (4 & h) ? -1 : 1, (5 & h) ? -1 : 1, (6 & h) ? -1 : 1, (7 & h) ? -1 : 1);
+        long long begin, end;
+        partRange(size, 8, part, parts, begin, end);
+        for (int k = 0; k < 2; k++){
+            double *x = arrays[k];
+            for (long long i = begin; i < end; i += 8){
+                __m512d v = _mm512_loadu_pd(x + i), partner = _mm512_mask_permutexvar_pd(v, 0xFF, partners, v); //masked form: no undefined source register
+                _mm512_storeu_pd(x + i, _mm512_mul_pd(_mm512_fmadd_pd(v, sign, partner), scale));
+            }
+        }
+    }
+}
+
+__attribute__((target("avx512f")))
+void toffoliAVX512(double *re, double *im, long long size, long long controlMask, int bit, int part, int parts){
+    long long lowControls = controlMask & 7, highControls = controlMask & ~7LL, T = 1LL << bit;
+    const __mmask8 lanes = laneMask8(lowControls);
+    double *arrays[2] = {re, im};
+    if (bit >= 3){
+        runPlan plan = planRuns(size, highControls | T, highControls);
+        long long begin, end;
+        partRange(plan.runs * plan.length, 8, part, parts, begin, end);
+        for (long long v = begin, n; v < end; v += n){
+            long long start = spanStart(plan, v, end, n);
+            for (int k = 0; k < 2; k++){
+                double *x = arrays[k] + start;
+                for (long long i = 0; i < n; i += 8){
+                    __m512d a = _mm512_loadu_pd(x + i), b = _mm512_loadu_pd(x + i + T);
+                    _mm512_storeu_pd(x + i, _mm512_mask_blend_pd(lanes, a, b));
+                    _mm512_storeu_pd(x + i + T, _mm512_mask_blend_pd(lanes, b, a));
+                }
+            }
+        }
+    } else {
+        int h = (int)T;
+        const __m512i partners = _mm512_setr_epi64(0 ^ h, 1 ^ h, 2 ^ h, 3 ^ h, 4 ^ h, 5 ^ h, 6 ^ h, 7 ^ h);
+        runPlan plan = planRuns(size, highControls, highControls);
+        long long begin, end;
+        partRange(plan.runs * plan.length, 8, part, parts, begin, end);
+        for (long long v = begin, n; v < end; v += n){
+            long long start = spanStart(plan, v, end, n);
+            for (int k = 0; k < 2; k++){
+                double *x = arrays[k] + start;
+                for (long long i = 0; i < n; i += 8){
+                    __m512d v = _mm512_loadu_pd(x + i);
+                    _mm512_storeu_pd(x + i, _mm512_mask_permutexvar_pd(v, lanes, partners, v));
+                }
+            }
+        }
+    }
+}
+
+__attribute__((target("avx512f")))
+void phaseAVX512(double *re, double *im, long long size, long long mask, double c, double s, int part, int parts){
+    long long high = mask & ~7LL;
+    const __mmask8 lanes = laneMask8(mask & 7);
+    const __m512d cv = _mm512_set1_pd(c), sv = _mm512_set1_pd(s);
+    runPlan plan = planRuns(size, high, high);
+    long long begin, end;
+    partRange(plan.runs * plan.length, 8, part, parts, begin, end);
+    for (long long v = begin, n; v < end; v += n){
+        long long start = spanStart(plan, v, end, n);
+        for (long long i = start; i < start + n; i += 8){
+            __m512d a = _mm512_loadu_pd(re + i), b = _mm512_loadu_pd(im + i);
+            __m512d newRe = _mm512_fmsub_pd(a, cv, _mm512_mul_pd(b, sv)), newIm = _mm512_fmadd_pd(a, sv, _mm512_mul_pd(b, cv));
+            _mm512_mask_storeu_pd(re + i, lanes, newRe);
+            _mm512_mask_storeu_pd(im + i, lanes, newIm);
+        }
+    }
+}
+#endif
+
+//----------------------------------FUSED GATE KERNELS--------------------------------------
+
+/* A fused gate is a dense 2^k x 2^k unitary (or a diagonal of 2^k phases) on the index bits bits[0] < ... < bits[k-1]: local index j
+ (bit b of j = index bit bits[b]) --> offset[j] from each base index, the bases being the indices with all k bits 0. When the bases
+ come in runs of at least a laneVector (bits[0] >= 3 for doubles), a laneVector of bases is done at once per local index. Long runs are
+ taken FUSED_BLOCK bases at a time, reading and writing each of the 2^k amplitude streams in one contiguous piece (interleaving all
+ 2^(k+1) streams base by base defeats the hardware prefetcher). Otherwise every base is done on its own. The matrix is row-major:
+ out[r] = sum over c of m[r * 2^k + c] * in[c]; only its nonzero entries are multiplied, listed once per call, since fused permutations
+ and phases are mostly zeros. */
+
+/* laneTraits<T>::vector: 64 bytes of T (8 doubles or 16 floats), one AVX-512 register, two AVX2 or four SSE2 ones: the generic code
+ below is compiled once per instruction set and precision */
+template <typename T> struct laneTraits {
+    typedef T vector __attribute__((vector_size(64)));
+    typedef typename conditional<sizeof(T) == 8, long long, int>::type lane;
+    typedef lane indices __attribute__((vector_size(64))); //lane numbers for __builtin_shuffle, and the result of lane comparisons
+};
+#define LANES(T) (64 / (int)sizeof(T))
+#define FUSED_BLOCK 64 //bases per block: a block's inputs (32 KB at k = 5) are copied into L1 before its rows are computed
+
+template <typename T>
+__attribute__((always_inline)) inline void fusedBody(T *re, T *im, long long size, const int *bits, int k, const double *mRe, const double *mIm,
+                                                     bool diagonal, int part, int parts){
+    typedef typename laneTraits<T>::vector laneVector;
+    const int lanes = LANES(T);
+    int dim = 1 << k;
+    long long offsets[1 << MAX_FUSED_QUBITS], groupMask = 0;
+    for (int b = 0; b < k; b++) groupMask |= 1LL << bits[b];
+    for (int j = 0; j < dim; j++){
+        offsets[j] = 0;
+        for (int b = 0; b < k; b++) if ((j >> b) & 1) offsets[j] |= 1LL << bits[b];
+    }
+    int rowStart[(1 << MAX_FUSED_QUBITS) + 1], cols[1 << (2 * MAX_FUSED_QUBITS)], count = 0; //nonzero entries of each row
+    T a[1 << (2 * MAX_FUSED_QUBITS)], b[1 << (2 * MAX_FUSED_QUBITS)];
+    for (int r = 0; r < dim && !diagonal; r++){
+        rowStart[r] = count;
+        for (int c = 0; c < dim; c++) if (mRe[r * dim + c] != 0 || mIm[r * dim + c] != 0){
+            cols[count] = c, a[count] = mRe[r * dim + c], b[count] = mIm[r * dim + c];
+            count++;
+        }
+    }
+    rowStart[dim] = count;
+    runPlan plan = planRuns(size, groupMask, 0);
+    long long begin, end;
+    if (plan.length >= lanes){
+        partRange(plan.runs * plan.length, lanes, part, parts, begin, end);
+        alignas(64) T inRe[1 << MAX_FUSED_QUBITS][FUSED_BLOCK], inIm[1 << MAX_FUSED_QUBITS][FUSED_BLOCK];
+        for (long long v = begin, n; v < end; v += n){
+            long long start = spanStart(plan, v, end, n);
+            for (long long i = start; i < start + n; i += FUSED_BLOCK){
+                long long length = min((long long)FUSED_BLOCK, start + n - i);
+                if (diagonal){ //one stream at a time: each local index only scales its own amplitudes
+                    for (int r = 0; r < dim; r++){
+                        laneVector c = (T)mRe[r] - (laneVector){}, s = (T)mIm[r] - (laneVector){};
+                        for (long long l = 0; l < length; l += lanes){
+                            laneVector x, y;
+                            __builtin_memcpy(&x, re + i + offsets[r] + l, sizeof(laneVector));
+                            __builtin_memcpy(&y, im + i + offsets[r] + l, sizeof(laneVector));
+                            laneVector outRe = c * x - s * y, outIm = c * y + s * x;
+                            __builtin_memcpy(re + i + offsets[r] + l, &outRe, sizeof(laneVector));
+                            __builtin_memcpy(im + i + offsets[r] + l, &outIm, sizeof(laneVector));
+                        }
+                    }
+                    continue;
+                }
+                if (plan.length < FUSED_BLOCK){ //short runs: the streams are close together, so a laneVector of bases is gathered straight into registers
+                    laneVector x[1 << MAX_FUSED_QUBITS], y[1 << MAX_FUSED_QUBITS];
+                    for (long long l = 0; l < length; l += lanes){
+                        for (int j = 0; j < dim; j++){
+                            __builtin_memcpy(&x[j], re + i + offsets[j] + l, sizeof(laneVector));
+                            __builtin_memcpy(&y[j], im + i + offsets[j] + l, sizeof(laneVector));
+                        }
+                        for (int r = 0; r < dim; r++){
+                            laneVector outRe = {}, outIm = {};
+                            for (int e = rowStart[r]; e < rowStart[r + 1]; e++){
+                                outRe += a[e] * x[cols[e]] - b[e] * y[cols[e]], outIm += a[e] * y[cols[e]] + b[e] * x[cols[e]];
+                            }
+                            __builtin_memcpy(re + i + offsets[r] + l, &outRe, sizeof(laneVector));
+                            __builtin_memcpy(im + i + offsets[r] + l, &outIm, sizeof(laneVector));
+                        }
+                    }
+                    continue;
+                }
+                for (int j = 0; j < dim; j++) for (long long l = 0; l < length; l += lanes){
+                    __builtin_memcpy(&inRe[j][l], re + i + offsets[j] + l, sizeof(laneVector));
+                    __builtin_memcpy(&inIm[j][l], im + i + offsets[j] + l, sizeof(laneVector));
+                }
+                for (int r = 0; r < dim; r++){
+                    for (long long l = 0; l < length; l += lanes){
+                        laneVector outRe = {}, outIm = {}, x, y;
+                        for (int e = rowStart[r]; e < rowStart[r + 1]; e++){
+                            __builtin_memcpy(&x, &inRe[cols[e]][l], sizeof(laneVector));
+                            __builtin_memcpy(&y, &inIm[cols[e]][l], sizeof(laneVector));
+                            outRe += a[e] * x - b[e] * y, outIm += a[e] * y + b[e] * x;
+                        }
+                        __builtin_memcpy(re + i + offsets[r] + l, &outRe, sizeof(laneVector));
+                        __builtin_memcpy(im + i + offsets[r] + l, &outIm, sizeof(laneVector));
+                    }
+                }
+            }
+        }
+    } else {
+        partRange(plan.runs * plan.length, 1, part, parts, begin, end);
+        T inRe[1 << MAX_FUSED_QUBITS], inIm[1 << MAX_FUSED_QUBITS];
+        for (long long v = begin, n; v < end; v += n){
+            long long start = spanStart(plan, v, end, n);
+            for (long long i = start; i < start + n; i++){
+                for (int j = 0; j < dim; j++) inRe[j] = re[i + offsets[j]], inIm[j] = im[i + offsets[j]];
+                for (int r = 0; r < dim; r++){
+                    T outRe = 0, outIm = 0;
+                    if (diagonal){
+                        outRe = mRe[r] * inRe[r] - mIm[r] * inIm[r], outIm = mRe[r] * inIm[r] + mIm[r] * inRe[r];
+                    } else {
+                        for (int e = rowStart[r]; e < rowStart[r + 1]; e++){
+                            int c = cols[e];
+                            outRe += a[e] * inRe[c] - b[e] * inIm[c], outIm += a[e] * inIm[c] + b[e] * inRe[c];
+                        }
+                    }
+                    re[i + offsets[r]] = outRe, im[i + offsets[r]] = outIm;
+                }
+            }
+        }
+    }
+}
+
+void fusedScalar(double *re, double *im, long long size, const int *bits, int k, const double *mRe, const double *mIm, bool diagonal, int part, int parts){
+    fusedBody<double>(re, im, size, bits, k, mRe, mIm, diagonal, part, parts);
+}
+
+#ifdef X86_KERNELS
+__attribute__((target("avx2,fma")))
+void fusedAVX2(double *re, double *im, long long size, const int *bits, int k, const double *mRe, const double *mIm, bool diagonal, int part, int parts){
+    fusedBody<double>(re, im, size, bits, k, mRe, mIm, diagonal, part, parts);
+}
+
+__attribute__((target("avx512f")))
+void fusedAVX512(double *re, double *im, long long size, const int *bits, int k, const double *mRe, const double *mIm, bool diagonal, int part, int parts){
+    fusedBody<double>(re, im, size, bits, k, mRe, mIm, diagonal, part, parts);
+}
+#endif
+
+//-----------------------------------BIT SWAPS----------------------------------------------
+
+/* A swap exchanges every amplitude whose index has bit high = 1, bit low = 0 with its partner (high = 0, low = 1): both are runs of
+ 2^low consecutive indices, so the plain loop below streams them and the compiler vectorizes it for any instruction set. */
+template <typename T>
+void swapBits(T *re, T *im, long long size, int low, int high, int part, int parts){
+    long long L = 1LL << low, H = 1LL << high;
+    runPlan plan = planRuns(size, L | H, H);
+    long long begin, end;
+    partRange(plan.runs * plan.length, 1, part, parts, begin, end);
+    for (long long v = begin, n; v < end; v += n){
+        long long start = spanStart(plan, v, end, n);
+        T *a = re + start, *b = re + start - H + L, *c = im + start, *d = im + start - H + L;
+        for (long long i = 0; i < n; i++){
+            swap(a[i], b[i]);
+            swap(c[i], d[i]);
+        }
+    }
+}
+
+template void swapBits<double>(double *re, double *im, long long size, int low, int high, int part, int parts);
+template void swapBits<float>(float *re, float *im, long long size, int low, int high, int part, int parts);
+
+//-----------------------------------PHASE TABLES-------------------------------------------
+
+/* The table index of amplitude i gathers k bits of base + i, so the phase is constant over aligned runs of 2^bits[0] indices. When
+ those runs are whole laneVectors (bits[0] >= 3 for doubles), each run is multiplied by its one phase. Otherwise the bits below 8 vary within every
+ aligned run of 256 indices: they are looked up in a 256-entry table, the rest are gathered once per run, and the run's 256 phases are
+ laid out contiguously (only when those other bits change) so the multiply stays a vector loop. The same code is compiled for every
+ instruction set and precision below. */
+
+template <typename T>
+__attribute__((always_inline)) inline void phaseTableBody(T *re, T *im, long long size, long long base, const int *bits, int k,
+                                                          const double *tRe, const double *tIm, int part, int parts){
+    typedef typename laneTraits<T>::vector laneVector;
+    const int lanes = LANES(T);
+    long long begin, end;
+    if (size < lanes){ //a vector shorter than one laneVector
+        partRange(size, 1, part, parts, begin, end);
+        for (long long i = begin; i < end; i++){
+            int j = 0;
+            for (int b = 0; b < k; b++) if (((base + i) >> bits[b]) & 1) j |= 1 << b;
+            T a = re[i], b = im[i];
+            re[i] = a * tRe[j] - b * tIm[j], im[i] = a * tIm[j] + b * tRe[j];
+        }
+        return;
+    }
+    if (k == 0 || (1LL << bits[0]) >= lanes){
+        long long run = k == 0 ? size : min(size, 1LL << bits[0]);
+        partRange(size, lanes, part, parts, begin, end);
+        for (long long i = begin, n; i < end; i += n){
+            n = min(end, (i | (run - 1)) + 1) - i;
+            int j = 0;
+            for (int b = 0; b < k; b++) if (((base + i) >> bits[b]) & 1) j |= 1 << b;
+            laneVector c = (T)tRe[j] - (laneVector){}, s = (T)tIm[j] - (laneVector){};
+            for (long long l = i; l < i + n; l += lanes){
+                laneVector x, y;
+                __builtin_memcpy(&x, re + l, sizeof(laneVector));
+                __builtin_memcpy(&y, im + l, sizeof(laneVector));
+                laneVector newRe = c * x - s * y, newIm = c * y + s * x;
+                __builtin_memcpy(re + l, &newRe, sizeof(laneVector));
+                __builtin_memcpy(im + l, &newIm, sizeof(laneVector));
+            }
+        }
+        return;
+    }
+    int lowCount = 0, low[256], last = -1;
+    alignas(64) T phRe[256], phIm[256];
+    while (lowCount < k && bits[lowCount] < 8) lowCount++;
+    for (int x = 0; x < 256; x++){
+        low[x] = 0;
+        for (int b = 0; b < lowCount; b++) if ((x >> bits[b]) & 1) low[x] |= 1 << b;
+    }
+    long long run = min(size, 256LL);
+    partRange(size, (int)run, part, parts, begin, end);
+    for (long long i = begin; i < end; i += run){
+        int high = 0;
+        for (int b = lowCount; b < k; b++) if (((base + i) >> bits[b]) & 1) high |= 1 << b;
+        if (high != last){
+            for (int x = 0; x < run; x++) phRe[x] = tRe[high | low[x]], phIm[x] = tIm[high | low[x]];
+            last = high;
+        }
+        for (long long l = 0; l < run; l += lanes){
+            laneVector x, y, c, s;
+            __builtin_memcpy(&x, re + i + l, sizeof(laneVector));
+            __builtin_memcpy(&y, im + i + l, sizeof(laneVector));
+            __builtin_memcpy(&c, phRe + l, sizeof(laneVector));
+            __builtin_memcpy(&s, phIm + l, sizeof(laneVector));
+            laneVector newRe = c * x - s * y, newIm = c * y + s * x;
+            __builtin_memcpy(re + i + l, &newRe, sizeof(laneVector));
+            __builtin_memcpy(im + i + l, &newIm, sizeof(laneVector));
+        }
+    }
+}
+
+void phaseTableScalar(double *re, double *im, long long size, long long base, const int *bits, int k, const double *tRe, const double *tIm, int part, int parts){
+    phaseTableBody<double>(re, im, size, base, bits, k, tRe, tIm, part, parts);
+}
+
+#ifdef X86_KERNELS
+__attribute__((target("avx2,fma")))
+void phaseTableAVX2(double *re, double *im, long long size, long long base, const int *bits, int k, const double *tRe, const double *tIm, int part, int parts){
+    phaseTableBody<double>(re, im, size, base, bits, k, tRe, tIm, part, parts);
+}
+
+__attribute__((target("avx512f")))
+void phaseTableAVX512(double *re, double *im, long long size, long long base, const int *bits, int k, const double *tRe, const double *tIm, int part, int parts){
+    phaseTableBody<double>(re, im, size, base, bits, k, tRe, tIm, part, parts);
+}
+#endif
+
+//--------------------------------SINGLE-PRECISION KERNELS----------------------------------
+
+/* The float kernels are the generic laneVector code: 16 floats per 64 bytes, so target bits 0-3 pair lanes of the same vector. A
+ Hadamard there takes its partners with one shuffle (lane j <-- lane j ^ 2^bit) as in the AVX-512 kernels, a Toffoli selects them in the
+ lanes whose control bits are set, and a phase multiplies the lanes outside its mask by 1. Vectors shorter than 16 amplitudes are done
+ one amplitude at a time. */
+
+template <typename T>
+__attribute__((always_inline)) inline void hadamardBody(T *re, T *im, long long size, int bit, int part, int parts){
+    typedef typename laneTraits<T>::vector laneVector;
+    typedef typename laneTraits<T>::indices laneIndices;
+    const int lanes = LANES(T);
+    const T scale = (T)M_SQRT1_2;
+    long long H = 1LL << bit, begin, end;
+    T *arrays[2] = {re, im};
+    if (size < lanes || H >= lanes){
+        int width = size < lanes ? 1 : lanes;
+        runPlan plan = planRuns(size, H, 0);
+        partRange(plan.runs * plan.length, width, part, parts, begin, end);
+        for (long long v = begin, n; v < end; v += n){
+            long long start = spanStart(plan, v, end, n);
+            for (int k = 0; k < 2; k++){
+                T *x = arrays[k] + start;
+                if (width == 1){
+                    for (long long i = 0; i < n; i++){
+                        T a = x[i], b = x[i + H];
+                        x[i] = scale * (a + b), x[i + H] = scale * (a - b);
+                    }
+                    continue;
+                }
+                for (long long i = 0; i < n; i += lanes){
+                    laneVector a, b;
+                    __builtin_memcpy(&a, x + i, sizeof(laneVector));
+                    __builtin_memcpy(&b, x + i + H, sizeof(laneVector));
+                    laneVector sum = scale * (a + b), difference = scale * (a - b);
+                    __builtin_memcpy(x + i, &sum, sizeof(laneVector));
+                    __builtin_memcpy(x + i + H, &difference, sizeof(laneVector));
+                }
+            }
+        }
+        return;
+    }
+    laneIndices partners;
+    laneVector sign;
+    for (int j = 0; j < lanes; j++) partners[j] = j ^ (int)H, sign[j] = (j & H) ? -1 : 1;
+    partRange(size, lanes, part, parts, begin, end);
+    for (int k = 0; k < 2; k++){
+        T *x = arrays[k];
+        for (long long i = begin; i < end; i += lanes){
+            laneVector v;
+            __builtin_memcpy(&v, x + i, sizeof(laneVector));
+            laneVector out = scale * (v * sign + __builtin_shuffle(v, partners));
+            __builtin_memcpy(x + i, &out, sizeof(laneVector));
+        }
+    }
+}
+
+template <typename T>
+__attribute__((always_inline)) inline void toffoliBody(T *re, T *im, long long size, long long controlMask, int bit, int part, int parts){
+    typedef typename laneTraits<T>::vector laneVector;
+    typedef typename laneTraits<T>::indices laneIndices;
+    const int lanes = LANES(T);
+    long long flip = 1LL << bit, begin, end;
+    T *arrays[2] = {re, im};
+    if (size < lanes){
+        runPlan plan = planRuns(size, controlMask | flip, controlMask);
+        partRange(plan.runs * plan.length, 1, part, parts, begin, end);
+        for (long long v = begin, n; v < end; v += n){
+            long long start = spanStart(plan, v, end, n);
+            for (long long i = start; i < start + n; i++) swap(re[i], re[i + flip]), swap(im[i], im[i + flip]);
+        }
+        return;
+    }
+    long long lowControls = controlMask & (lanes - 1), highControls = controlMask & ~(long long)(lanes - 1);
+    laneIndices selected, partners; //selected: -1 in the lanes whose control bits are all set
+    for (int j = 0; j < lanes; j++) selected[j] = (j & lowControls) == lowControls ? -1 : 0, partners[j] = j ^ (int)(flip & (lanes - 1));
+    runPlan plan = flip >= lanes ? planRuns(size, highControls | flip, highControls) : planRuns(size, highControls, highControls);
+    partRange(plan.runs * plan.length, lanes, part, parts, begin, end);
+    for (long long v = begin, n; v < end; v += n){
+        long long start = spanStart(plan, v, end, n);
+        for (int k = 0; k < 2; k++){
+            T *x = arrays[k] + start;
+            for (long long i = 0; i < n; i += lanes){
+                laneVector a, b;
+                __builtin_memcpy(&a, x + i, sizeof(laneVector));
+                if (flip >= lanes){
+                    __builtin_memcpy(&b, x + i + flip, sizeof(laneVector));
+                    laneVector newA = selected ? b : a, newB = selected ? a : b;
+                    __builtin_memcpy(x + i, &newA, sizeof(laneVector));
+                    __builtin_memcpy(x + i + flip, &newB, sizeof(laneVector));
+                } else {
+                    b = __builtin_shuffle(a, partners);
+                    laneVector out = selected ? b : a;
+                    __builtin_memcpy(x + i, &out, sizeof(laneVector));
+                }
+            }
+        }
+    }
+}
+
+template <typename T>
+__attribute__((always_inline)) inline void phaseBody(T *re, T *im, long long size, long long mask, double c, double s, int part, int parts){
+    typedef typename laneTraits<T>::vector laneVector;
+    const int lanes = LANES(T);
+    long long begin, end;
+    if (size < lanes){
+        runPlan plan = planRuns(size, mask, mask);
+        partRange(plan.runs * plan.length, 1, part, parts, begin, end);
+        for (long long v = begin, n; v < end; v += n){
+            long long start = spanStart(plan, v, end, n);
+            for (long long i = start; i < start + n; i++){
+                T a = re[i], b = im[i];
+                re[i] = a * (T)c - b * (T)s, im[i] = a * (T)s + b * (T)c;
+            }
+        }
+        return;
+    }
+    long long low = mask & (lanes - 1), high = mask & ~(long long)(lanes - 1);
+    laneVector cv, sv; //the phase in the selected lanes, 1 elsewhere
+    for (int j = 0; j < lanes; j++) cv[j] = (j & low) == low ? (T)c : 1, sv[j] = (j & low) == low ? (T)s : 0;
+    runPlan plan = planRuns(size, high, high);
+    partRange(plan.runs * plan.length, lanes, part, parts, begin, end);
+    for (long long v = begin, n; v < end; v += n){
+        long long start = spanStart(plan, v, end, n);
+        for (long long i = start; i < start + n; i += lanes){
+            laneVector x, y;
+            __builtin_memcpy(&x, re + i, sizeof(laneVector));
+            __builtin_memcpy(&y, im + i, sizeof(laneVector));
+            laneVector newRe = cv * x - sv * y, newIm = sv * x + cv * y;
+            __builtin_memcpy(re + i, &newRe, sizeof(laneVector));
+            __builtin_memcpy(im + i, &newIm, sizeof(laneVector));
+        }
+    }
+}
+
+#define FLOAT_KERNELS(SET, TARGET) \
+TARGET void hadamard##SET##Float(float *re, float *im, long long size, int bit, int part, int parts){ \
+    hadamardBody<float>(re, im, size, bit, part, parts); \
+} \
+TARGET void toffoli##SET##Float(float *re, float *im, long long size, long long controlMask, int bit, int part, int parts){ \
+    toffoliBody<float>(re, im, size, controlMask, bit, part, parts); \
+} \
+TARGET void phase##SET##Float(float *re, float *im, long long size, long long mask, double c, double s, int part, int parts){ \
+    phaseBody<float>(re, im, size, mask, c, s, part, parts); \
+} \
+TARGET void fused##SET##Float(float *re, float *im, long long size, const int *bits, int k, const double *mRe, const double *mIm, bool diagonal, int part, int parts){ \
+    fusedBody<float>(re, im, size, bits, k, mRe, mIm, diagonal, part, parts); \
+} \
+TARGET void phaseTable##SET##Float(float *re, float *im, long long size, long long base, const int *bits, int k, const double *tRe, const double *tIm, int part, int parts){ \
+    phaseTableBody<float>(re, im, size, base, bits, k, tRe, tIm, part, parts); \
+}
+
+FLOAT_KERNELS(Scalar, )
+#ifdef X86_KERNELS
+FLOAT_KERNELS(AVX2, __attribute__((target("avx2,fma"))))
+FLOAT_KERNELS(AVX512, __attribute__((target("avx512f"))))
+#endif
+
+//----------------------------------KERNEL SELECTION----------------------------------------
+
+template <>
+vector<gateKernels> availableKernels<double>(){
+    vector<gateKernels> kernels;
+    kernels.push_back({"scalar", 1, hadamardScalar, toffoliScalar, phaseScalar, fusedScalar, phaseTableScalar});
+#ifdef X86_KERNELS
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma")) kernels.push_back({"AVX2", 4, hadamardAVX2, toffoliAVX2, phaseAVX2, fusedAVX2, phaseTableAVX2});
+    if (__builtin_cpu_supports("avx512f")) kernels.push_back({"AVX-512", 8, hadamardAVX512, toffoliAVX512, phaseAVX512, fusedAVX512, phaseTableAVX512});
+#endif
+    return kernels;
+}
+
+template <>
+vector<basicGateKernels<float>> availableKernels<float>(){
+    vector<basicGateKernels<float>> kernels;
+    kernels.push_back({"scalar float", 1, hadamardScalarFloat, toffoliScalarFloat, phaseScalarFloat, fusedScalarFloat, phaseTableScalarFloat});
+#ifdef X86_KERNELS
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma")) kernels.push_back({"AVX2 float", 8, hadamardAVX2Float, toffoliAVX2Float, phaseAVX2Float, fusedAVX2Float, phaseTableAVX2Float});
+    if (__builtin_cpu_supports("avx512f")) kernels.push_back({"AVX-512 float", 16, hadamardAVX512Float, toffoliAVX512Float, phaseAVX512Float, fusedAVX512Float, phaseTableAVX512Float});
+#endif
+    return kernels;
+}
+
+template <typename T>
+const basicGateKernels<T> &selectKernels(long long size){
+    static vector<basicGateKernels<T>> kernels = availableKernels<T>();
+    int best = 0;
+    for (int k = 1; k < (int)kernels.size(); k++) if (kernels[k].width <= size) best = k;
+    return kernels[best];
+}
+
+template const basicGateKernels<double> &selectKernels<double>(long long size);
+template const basicGateKernels<float> &selectKernels<float>(long long size);
+
+//-----------------------------------MICROBENCHMARK-----------------------------------------
+
+/* Each kernel is timed on an N-qubit vector for a target bit inside a register (bit 0) and a high one (bit N - 1); the Toffoli and
+ controlled phase use the two bits next to the target as controls. Throughput is counted over the amplitudes the gate changes (1/4 of the
+ vector for Toffoli and controlled phase), in amplitudes per second and as GB/s of reading and writing them once. Controls inside a
+ register make a kernel stream lanes it leaves unchanged, so those rows fall below the memory bandwidth. Double kernels run first, then
+ float ones: a float amplitude is half the bytes, so a bandwidth-bound gate should reach about twice the amplitudes per second. */
+template <typename T>
+void benchmarkPrecision(int N, int repeats){
+    long long size = 1LL << N;
+    T *re = allocAmplitudes<T>(size, false, NULL);
+    if (re == NULL) return;
+    T *im = re + size;
+    re[0] = 1;
+    vector<basicGateKernels<T>> kernels = availableKernels<T>();
+    cout.precision(3);
+    for (const basicGateKernels<T> &k : kernels){
+        if (k.width > size) continue;
+        for (int bit : {0, N - 1}){
+            int c1 = (bit + 1) % N, c2 = (bit + 2) % N;
+            long long controls = (1LL << c1) | (1LL << c2);
+            for (int kernel = 0; kernel < 3; kernel++){
+                struct timeval t0, t1;
+                gettimeofday(&t0, NULL);
+                for (int r = 0; r < repeats; r++){
+                    if (kernel == 0) k.hadamard(re, im, size, bit, 0, 1);
+                    else if (kernel == 1) k.toffoli(re, im, size, controls, bit, 0, 1);
+                    else k.phase(re, im, size, controls | (1LL << bit), cos(0.1), sin(0.1), 0, 1);
+                }
+                gettimeofday(&t1, NULL);
+                double seconds = (t1.tv_sec - t0.tv_sec) + (t1.tv_usec - t0.tv_usec) / (double) 1000000;
+                double touched = (kernel == 0) ? size : size / 4.0;
+                cout << k.name << " " << (kernel == 0 ? "Hadamard" : kernel == 1 ? "Toffoli" : "phase") << " (bit " << bit << "): "
+                     << touched * repeats / seconds / 1e9 << " G amplitudes/second, " << 4 * sizeof(T) * touched * repeats / seconds / 1e9 << " GB/s\n";
+            }
+        }
+    }
+    free(re);
+}
+
+void benchmarkKernels(int N, int repeats){
+    cout << "Benchmark: [state vector gate kernels, " << N << " qubits]\n";
+    benchmarkPrecision<double>(N, repeats);
+    benchmarkPrecision<float>(N, repeats);
+    cout << "\n";
+}
@@ -0,0 +1,63 @@
+//
+//  gateKernels.hpp
+//  PocketSimulator
+//
+//  Created on 10/16/26.
+//  Copyright © 2017. All rights reserved.
+//
+
+#ifndef gateKernels_hpp
+#define gateKernels_hpp
+
+#include <stdio.h>
+#include <vector>
+using namespace std;
+
+#define MAX_FUSED_QUBITS 5 //widest fused gate: 2^5 x 2^5 matrix
+#define PHASE_TABLE_QUBITS 12 //widest phase table: 2^12 phases (64 KB)
+
+/* gateKernels: one instruction set's state-vector gate kernels, on a split (structure-of-arrays) vector: re[i] and im[i] hold the real
+ and imaginary parts of amplitude i, for i < size (a power of 2). Bits are amplitude index bits (qubit q --> bit N - q - 1). The kernels
+ come in double precision (gateKernels) and single precision (basicGateKernels<float>); matrices, tables and phases are always given in
+ double and rounded once per call.
+
+ hadamard: H on 'bit'
+ toffoli: swaps the amplitude pairs differing in 'bit' where every bit of controlMask is set
+ phase: multiplies the amplitudes where every bit of mask is set by c + si
+ fused: applies a k-qubit (k <= MAX_FUSED_QUBITS) unitary, given as its real and imaginary parts (row-major 2^k x 2^k, or just the 2^k
+ entries when diagonal), to the index bits bits[0] < ... < bits[k - 1]
+ phaseTable: multiplies amplitude i by the table entry tRe[j] + tIm[j]i, where bit b of j is index bit bits[b] (ascending, k <=
+ PHASE_TABLE_QUBITS) of base + i: a whole diagonal over k qubits in one sweep. re, im may be a block of the vector starting at index base.
+ 
+ A call applies slice 'part' (0 to parts - 1) of the gate: running every slice, on any threads, applies the whole gate. Slices are equal
+ shares of the visited amplitudes in index order, so when the gate's control and target bits are below log2(size/parts), slice p stays
+ within amplitudes [p * size/parts, (p + 1) * size/parts): the memory the thread running it first touched. */
+template <typename T>
+struct basicGateKernels {
+    const char *name;
+    int width; //T values per vector register: size must be at least this
+    void (*hadamard)(T *re, T *im, long long size, int bit, int part, int parts);
+    void (*toffoli)(T *re, T *im, long long size, long long controlMask, int bit, int part, int parts);
+    void (*phase)(T *re, T *im, long long size, long long mask, double c, double s, int part, int parts);
+    void (*fused)(T *re, T *im, long long size, const int *bits, int k, const double *mRe, const double *mIm, bool diagonal, int part, int parts);
+    void (*phaseTable)(T *re, T *im, long long size, long long base, const int *bits, int k, const double *tRe, const double *tIm, int part, int parts);
+};
+typedef basicGateKernels<double> gateKernels;
+
+/* swapBits: exchanges index bits low < high of the whole vector (slice 'part' of 'parts', as for the kernels): afterwards the amplitude
+ of index i is at i with bits low and high swapped */
+template <typename T>
+void swapBits(T *re, T *im, long long size, int low, int high, int part, int parts);
+
+template <typename T>
+const basicGateKernels<T> &selectKernels(long long size); //widest kernels of precision T supported by this CPU for a vector of 'size' amplitudes
+
+template <typename T>
+vector<basicGateKernels<T>> availableKernels(); //every kernel set of precision T this CPU supports, scalar first
+
+template <> vector<basicGateKernels<double>> availableKernels<double>();
+template <> vector<basicGateKernels<float>> availableKernels<float>();
+
+void benchmarkKernels(int N, int repeats); //prints the throughput of every available kernel, in both precisions, on an N-qubit vector
+
+#endif /* gateKernels_hpp */
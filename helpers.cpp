@@ -8,6 +8,8 @@
 #include "helpers.hpp"
 #include <string>
 #include <iostream>
+#include <fstream>
+#include <limits>
 #include <math.h>
 
 using namespace std;
@@ -162,10 +164,40 @@ string writeAdder(int N){ //Writes a draper adder circuit
     return out;
 }
 
+string randBits(int N){ //random N-bit string
+    string result = "";
+    for (int i = 0; i < N; i++) result += (rand() % 2) ? "1" : "0";
+    return result;
+}
+
+string addBits(string a, string b){ //a + b for equal-length bit strings (most significant bit first), modulo 2^length
+    string result = a;
+    int carry = 0;
+    for (int i = (int)a.length() - 1; i >= 0; i--){
+        int sum = (a[i] - '0') + (b[i] - '0') + carry;
+        result[i] = '0' + sum % 2;
+        carry = sum / 2;
+    }
+    return result;
+}
+
 int bitDiff(int a, int b){
     return __builtin_popcount(a ^ b);
 }
 
+long long availableMemory(){ //MemAvailable (free memory plus the page cache the kernel can reclaim); unknown elsewhere
+#ifdef __linux__
+    ifstream meminfo("/proc/meminfo");
+    string key;
+    long long kilobytes;
+    while (meminfo >> key >> kilobytes){
+        if (key == "MemAvailable:") return kilobytes * 1024;
+        meminfo.ignore(numeric_limits<streamsize>::max(), '\n');
+    }
+#endif
+    return 0;
+}
+
 void resetCounter(bool *reached, int n){
     for (int i = 0; i < n; i++){
         reached[i] = false;
@@ -43,8 +43,31 @@ string writeQFT(int N); //writes a QFT circuit on n qubits
 
 string writeAdder(int N); //Writes a draper adder circuit
 
+string randBits(int N); //random N-bit string, for registers too wide for an int
+
+string addBits(string a, string b); //a + b modulo 2^length for equal-length bit strings (most significant bit first)
+
 int bitDiff(int a, int b); //Returns bit difference between a and b
 
+/* stateTraits: the popcount of a basis state type wider than int (bitsets such as wideState, unless specialized below) */
+template <typename S> struct stateTraits {
+    static int popcount(const S &x){ return (int)x.count(); }
+};
+template <> struct stateTraits<int> {
+    static int popcount(int x){ return __builtin_popcount(x); }
+};
+template <> struct stateTraits<unsigned long long> {
+    static int popcount(unsigned long long x){ return __builtin_popcountll(x); }
+};
+template <> struct stateTraits<__uint128_t> {
+    static int popcount(__uint128_t x){ return __builtin_popcountll((unsigned long long)x) + __builtin_popcountll((unsigned long long)(x >> 64)); }
+};
+
+template <typename S>
+int bitDiff(const S &a, const S &b){ return stateTraits<S>::popcount(a ^ b); } //bitDiff for any state type S
+
+long long availableMemory(); //bytes of memory available for new allocations without swapping, or 0 if unknown (only read on Linux)
+
 void resetCounter(bool *reached, int n); //helper method for layer separation in Aaronson's Savitch implementation
 
 #endif /* helpers_hpp */
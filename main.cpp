@@ -16,9 +16,20 @@
 #define _USE_MATH_DEFINES
 
 #include "helpers.hpp"
+#include "circuit.hpp"
 #include "stateVector.hpp"
+#include "gateKernels.hpp"
 #include "savitch.hpp"
 #include "pathIntegral.hpp"
+#include "meetInMiddle.hpp"
+#include "bitSliced.hpp"
+#include "shardedPath.hpp"
+#include "pathSampling.hpp"
+#include "widePath.hpp"
+#include "distributedVector.hpp"
+#include "outOfCore.hpp"
+#include "sparseVector.hpp"
+#include "shotSampling.hpp"
 
 using namespace std;
 
@@ -43,16 +54,76 @@ using namespace std;
  
  5 = write and execute a Draper adder circuit (used in SEQCSim)
  
- The algorithmSetting variable controls whether to run the PocketSimulator recursive algorithm (= 0), the classic state vector implementation (= 1), or Aaronson's simulation algorithm (= 2). */
+ The algorithmSetting variable controls whether to run the PocketSimulator recursive algorithm (= 0), the classic state vector implementation (= 1, on numThreads threads), or Aaronson's simulation algorithm (= 2).
+ 
+ 3 = run the PocketSimulator algorithm in parallel on numThreads threads (0 = all cores)
+ 
+ 4 = run the PocketSimulator algorithm for a batch of batchSize end states at once (endState plus random ones)
+ 
+ 5 = run the meet-in-the-middle PocketSimulator algorithm, using at most memoryBudget bytes for its intermediate states
+ 
+ 6 = run the PocketSimulator algorithm with exact integer phase accumulation
+ 
+ 7 = run the PocketSimulator algorithm with a cache of up to cacheBytes bytes for repeated subtrees
+ 
+ 8 = run the iterative (explicit stack) PocketSimulator algorithm
+ 
+ 9 = benchmark the recursive and iterative PocketSimulator algorithms against each other (nodes/second)
+ 
+ 10 = run the PocketSimulator algorithm with its last Hadamard levels evaluated by the bit-sliced (many paths at once) kernel
+ 
+ 11 = estimate the amplitude by Monte Carlo path sampling, for sampleSeconds seconds or until the standard error is at most sampleError (0 = unused)
+ 
+ 12 = benchmark the state vector gate kernels (scalar, AVX2, AVX-512 as available) on an N-qubit vector
+ 
+ 13 = run the state vector algorithm split across distributedRanks processes on this host, exchanging amplitudes over transportSpec
+ 
+ 14 = run the state vector algorithm with the amplitudes in the file vectorPath (for vectors larger than memory), streamed in chunks of chunkBytes
+ 
+ 15 = run the state vector algorithm on the nonzero amplitudes only (a hash table), switching to the dense vector past denseFraction of the states
+ 
+ COMMAND LINE (for long runs split across processes/machines; every process must be given the same --seed and circuit settings;
+    --shard, --rank and --transport need N <= MAX_INT_QUBITS, since wider registers only run the single-process wide path integral)
+ --seed s: seed for the random circuit and states (default: the current time)
+ --gates path: gate file path (overrides gatePath)
+ --shard i/k: run only shard i (0 to k-1) of the path tree and write its partial amplitude to the --out file, checkpointing every checkpointSeconds.
+    A rerun of an unfinished shard resumes from its checkpoint. Shards sharing a gate file should use circuitSetting 0 (so none rewrites it).
+ --out file: shard file path (default shard_i_of_k.txt)
+ --reduce f1 f2 ...: sum the finished shard files f1, f2, ... into the final amplitude
+ --rank i/k: run only rank i (0 to k-1, k a power of 2) of a distributed state vector simulation; rank 0 prints the result
+ --transport spec: how the ranks exchange amplitudes (default transportSpec): shm:name (POSIX shared memory) or socket:path (Unix sockets) */
 
-int N = 18;
+int N = 18; //above MAX_INT_QUBITS (31), only the wide-register path integral is run (up to 256 qubits)
 int startState, endState;
+string startBits, endBits; //start and end states of registers wider than MAX_INT_QUBITS, as bit strings (qubit 0 first)
 bool showRuntime = true; //controls whether runtime details are printed on console
 string gatePath = "/Users/AShi/Documents/Repos/PocketSimulator/PocketSimulator/gates.txt"; //Directory path to gate file
 ifstream in = ifstream(gatePath);
 
 int circuitSetting = 3; //Circuit setting control
 int algorithmSetting = 1; //Algorithm setting control
+bool hugePages = true; //Back the state vector with transparent huge pages
+int fusionQubits = 5; //State vector: fuse consecutive gates on up to this many qubits into one pass where that is cheaper (1 = no fusion, at most 5)
+bool cacheBlocking = true; //State vector: apply runs of gates one L2-sized block at a time, swapping qubits into the block as needed
+bool lazyQubits = true; //State vector: a qubit gets a dimension in the vector only once a gate puts it in superposition (classical until then)
+int precision = DOUBLE_PRECISION; //State vector: DOUBLE_PRECISION, SINGLE_PRECISION (half the memory and bandwidth) or MIXED_PRECISION (float amplitudes, double norms)
+bool precisionDrift = true; //State vector: in single or mixed precision, also report the drift from the double-precision result
+long long shots = 0; //State vector: measurement samples drawn from the final state (0 = none), with the --seed
+vector<int> measuredQubits; //State vector: qubits measured by the shots, in outcome order (empty = every qubit)
+string histogramPath = "shots.csv"; //State vector: histogram of the shots, as CSV if the path ends in .csv, binary otherwise (see shotSampling.cpp)
+int distributedRanks = 4; //Distributed state vector: processes (a power of 2), each holding 1/distributedRanks of the amplitudes
+string transportSpec = "shm:pocketsim"; //Distributed state vector: shm:name (POSIX shared memory) or socket:path (Unix domain sockets), see rankTransport.hpp
+string vectorPath = "stateVector.bin"; //Out-of-core state vector: file holding the amplitudes during the run (on a fast disk), deleted at the end
+long long chunkBytes = 1LL << 26; //Out-of-core state vector: bytes of amplitudes per chunk (3 pairs of chunks are kept in memory)
+double pruneCutoff = 1e-12; //Sparse state vector: amplitudes of at most this magnitude are dropped
+double denseFraction = 1.0 / 16; //Sparse state vector: switch to the dense vector once more than this fraction of the states are nonzero
+int numThreads = 0; //Thread count for parallel algorithms (0 = use every core)
+int batchSize = 100; //Number of end states computed by the batch algorithm
+long long memoryBudget = 1LL << 30; //Memory (bytes) the meet-in-the-middle algorithm may use
+long long cacheBytes = 1LL << 28; //Memory (bytes) for the cached path integral's subtree cache
+double sampleSeconds = 10, sampleError = 0; //Monte Carlo stopping rules: time budget (seconds), target standard error (0 = unused)
+bool weightedSampling = true; //Monte Carlo: draw only branches that can still reach endState
+int checkpointSeconds = 600; //Seconds between shard checkpoints (command line --shard only)
 
 //VARIABLE FOR SETTING 0 ONLY: user-inputted circuit
 int nonPhaseGates = 0; //Number of gates in circuit EXCLUDING PHASE GATES
@@ -61,9 +132,51 @@ int nonPhaseGates = 0; //Number of gates in circuit EXCLUDING PHASE GATES
 //------------------------------------MAIN METHOD-------------------------------------------------
 
 int main(int argc, const char * argv[]){
-    srand((int)time(0)); //Set seed for random gates/start and end states
-    startState = rand()%(int)pow(2,N), endState = rand()%(int)pow(2,N);
     cout << fixed;
+    int seed = (int)time(0), shard = 0, shards = 0, rank = 0, ranks = 0;
+    bool transportSet = false;
+    string shardPath;
+    vector<string> reducePaths;
+    for (int i = 1; i < argc; i++){ //Command line options (see control panel)
+        string arg = argv[i];
+        if (arg == "--reduce"){
+            while (i + 1 < argc) reducePaths.push_back(argv[++i]);
+        } else if (i + 1 >= argc){
+            cout << "Missing value for " << arg << "\n";
+            return 1;
+        } else if (arg == "--seed") seed = atoi(argv[++i]);
+        else if (arg == "--gates") gatePath = argv[++i];
+        else if (arg == "--out") shardPath = argv[++i];
+        else if (arg == "--shard"){
+            if (sscanf(argv[++i], "%d/%d", &shard, &shards) != 2 || shards <= 0 || shard < 0 || shard >= shards){
+                cout << "Expected --shard i/k with 0 <= i < k\n";
+                return 1;
+            }
+        } else if (arg == "--rank"){
+            if (sscanf(argv[++i], "%d/%d", &rank, &ranks) != 2 || ranks <= 0 || rank < 0 || rank >= ranks){
+                cout << "Expected --rank i/k with 0 <= i < k\n";
+                return 1;
+            }
+        } else if (arg == "--transport") transportSpec = argv[++i], transportSet = true;
+        else {
+            cout << "Unknown option " << arg << "\n";
+            return 1;
+        }
+    }
+    if (!reducePaths.empty()){
+        reduceShards(reducePaths);
+        return 0;
+    }
+    if (N > MAX_INT_QUBITS && (shards || ranks || transportSet)){ //only the single-process wide-register path integral handles these widths
+        cout << "--shard, --rank and --transport are not supported above " << MAX_INT_QUBITS << " qubits (the wide-register path integral runs as one process)\n";
+        return 1;
+    }
+    if (shards && shardPath.empty()) shardPath = "shard_" + to_string(shard) + "_of_" + to_string(shards) + ".txt";
+    
+    srand(seed); //Set seed for random gates/start and end states
+    bool wide = N > MAX_INT_QUBITS;
+    if (wide) startBits = randBits(N), endBits = randBits(N);
+    else startState = (int)(rand() % (1LL << N)), endState = (int)(rand() % (1LL << N)); //1LL: 2^31 does not fit an int at N = MAX_INT_QUBITS
     
     switch (circuitSetting){
         case 0: //Execute user-inputted circuit from gates.txt
@@ -99,7 +212,7 @@ int main(int argc, const char * argv[]){
             ofstream out (gatePath);
             string circuit;
             nonPhaseGates = (int)(2*N/3)*2 + N;
-            startState = 0;
+            startState = 0, startBits = string(N, '0');
             circuit = paradigmCircuit(2*N/3, N);
             out << circuit;
             out.close();
@@ -127,20 +240,59 @@ int main(int argc, const char * argv[]){
             out << circuit;
             out.close();
             
+            cout << "Circuit type: [Draper adder]\n";
+            if (wide){
+                string a = randBits(N/2), b = randBits(N/2), sum = addBits(a, b), pad(N % 2, '0');
+                startBits = pad + a + b, endBits = pad + a + sum;
+                cout << "Confirming addition of " << a << " + " << b << " = " << sum << " (modulo 2^" << N/2 << ")\n";
+                break;
+            }
             int a = rand()%(int)pow(2,N/2), b = rand()%(int)pow(2,N/2), sum = (a + b)%(int)pow(2,N/2);
             startState = a*pow(2, N/2) + b, endState = startState - b + sum;
             
-            cout << "Circuit type: [Draper adder]\n";
             cout << "Confirming addition of " << a << " + " << b << " = " << sum << " (modulo " << (int)pow(2, N/2) << ")\n";
             break;
         }
         default: break;
     }
     
+    if (wide){ //int states would overflow: every algorithm setting runs the wide-register path integral
+        widePathIntegral(gatePath, N, startBits, endBits, showRuntime);
+        return 0;
+    }
+    if (shards){ //Command line shard run: only this process's part of the path tree
+        shardedPathIntegral(gatePath, N, startState, endState, shard, shards, shardPath, checkpointSeconds, showRuntime);
+        return 0;
+    }
+    if (ranks){ //Command line rank: this process's share of a distributed state vector
+        distributedStateVector(gatePath, N, startState, endState, fusionQubits, transportSpec, rank, ranks, showRuntime);
+        return 0;
+    }
+    
     switch(algorithmSetting){
         case 0: pathIntegral(gatePath, N, startState, endState, nonPhaseGates, showRuntime); break;
-        case 1: stateVector(gatePath, N, startState, endState, false, showRuntime); break;
+        case 1: stateVector(gatePath, N, startState, endState, false, hugePages, numThreads, fusionQubits, cacheBlocking, lazyQubits, precision, precisionDrift,
+                            {shots, measuredQubits, (unsigned long long)seed, histogramPath}, showRuntime); break;
         case 2: savitch(gatePath, N, startState, endState, false, showRuntime); break;
+        case 3: parallelPathIntegral(gatePath, N, startState, endState, nonPhaseGates, numThreads, showRuntime); break;
+        case 4:
+        {
+            vector<int> endStates(1, endState);
+            for (int i = 1; i < batchSize; i++) endStates.push_back((int)(rand() % (1LL << N)));
+            batchPathIntegral(gatePath, N, startState, endStates, nonPhaseGates, showRuntime);
+            break;
+        }
+        case 5: meetInMiddle(gatePath, N, startState, endState, memoryBudget, showRuntime); break;
+        case 6: exactPathIntegral(gatePath, N, startState, endState, nonPhaseGates, showRuntime); break;
+        case 7: cachedPathIntegral(gatePath, N, startState, endState, cacheBytes, showRuntime); break;
+        case 8: iterativePathIntegral(gatePath, N, startState, endState, showRuntime); break;
+        case 9: benchmarkPathEngines(gatePath, N, startState, endState, 5); break;
+        case 10: bitSlicedPathIntegral(gatePath, N, startState, endState, showRuntime); break;
+        case 11: sampledPathIntegral(gatePath, N, startState, endState, sampleSeconds, sampleError, weightedSampling, rand(), showRuntime); break;
+        case 12: benchmarkKernels(N, 10); break;
+        case 13: localDistributedStateVector(gatePath, N, startState, endState, fusionQubits, transportSpec, distributedRanks, showRuntime); break;
+        case 14: outOfCoreStateVector(gatePath, N, startState, endState, fusionQubits, vectorPath, chunkBytes, numThreads, showRuntime); break;
+        case 15: sparseStateVector(gatePath, N, startState, endState, pruneCutoff, denseFraction, fusionQubits, cacheBlocking, numThreads, showRuntime); break;
         default: break;
     }
     
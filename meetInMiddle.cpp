@@ -0,0 +1,153 @@
+//
+//  meetInMiddle.cpp
+//  PocketSimulator
+//
+//  Created on 10/16/26.
+//  Copyright © 2017. All rights reserved.
+//
+#include <iostream>
+#include <complex>
+#include <fstream>
+#include <unordered_map>
+#include <time.h>
+#include <sys/time.h>
+#include <sys/resource.h>
+#include <math.h>
+#define _USE_MATH_DEFINES
+
+#include "meetInMiddle.hpp"
+#include "pathIntegral.hpp"
+#include "circuit.hpp"
+#include "helpers.hpp"
+using namespace std;
+
+//MEET IN THE MIDDLE VARIABLES
+#define ENTRY_BYTES 64 //estimated memory per hash map entry (key, amplitude, node and bucket overhead)
+extern int N;
+extern int startState, endState;
+extern vector<gateOp> circuit;
+extern vector<int> lightCone;
+vector<int> changesBefore; //changesBefore[g]: # of changing (non-phase) gates among gates 0 to g - 1
+unordered_map<int, complex<double>> middle; //intermediate state --> summed amplitude <x|C_1|startState>
+int cut; //gates 0 to cut - 1 form C_1, gates cut to the end form C_2
+complex<double> joined;
+
+//-----------------------------MEET IN THE MIDDLE PATH SUMMING-----------------------------
+
+/* A bidirectional version of the path integral: the circuit is split as C = C_2 C_1 at a gate index 'cut', and
+ <y|C|x> = sum over intermediate basis states z of <y|C_2|z><z|C_1|x>.
+ 
+ The forward half enumerates every path of C_1 from startState and sums their amplitudes into a hash map keyed by z. The backward half
+ then enumerates the paths of C_2 from endState towards the cut (using <z'|H|z> = (-1)^(z'_t z_t)/sqrt(2), and the fact that Toffoli and
+ phase gates are their own transpose) and joins each one against the map as it reaches the cut.
+ 
+ With h_1 and h_2 Hadamards on either side, this takes time O(t(2^h_1 + 2^h_2)) and space O(min(2^h_1, 2^n)): about 2^(h/2) time when the
+ map fits. The cut is placed after the largest h_1 <= h/2 whose map fits the memory budget; if not even one Hadamard fits, the original
+ linear-space complexPathStep is used instead. Both halves use Hamming-distance pruning against the far end state, and the forward half
+ also uses light-cone pruning. */
+
+void forwardStep(int pos, int state, complex<double> phase){
+    while (pos < cut){
+        const gateOp &op = circuit[pos++];
+        if (bitDiff(state, endState) > changesBefore.back() - changesBefore[pos - 1]) return; //end state out of reach
+        if ((state ^ endState) & ~lightCone[pos - 1]) return; //or outside the light cone of the remaining gates
+        switch (op.gate){
+            case 'h':
+            {
+                int oneFactor = (state & op.targetMask) ? -1 : 1;
+                forwardStep(pos, state & ~op.targetMask, M_SQRT1_2 * phase);
+                forwardStep(pos, state | op.targetMask, oneFactor * M_SQRT1_2 * phase);
+                return;
+            }
+            case 't':
+            {
+                if ((state & op.controlMask) == op.controlMask) state ^= op.targetMask;
+                break;
+            }
+            case 'p':
+            {
+                if ((state & op.controlMask) == op.controlMask) phase *= op.phase;
+                break;
+            }
+            default: break;
+        }
+    }
+    middle[state] += phase;
+}
+
+void backwardStep(int pos, int state, complex<double> phase){ //pos: one past the next gate to undo
+    while (pos > cut){
+        const gateOp &op = circuit[--pos];
+        if (bitDiff(state, startState) > changesBefore[pos + 1]) return; //start state out of reach
+        switch (op.gate){
+            case 'h':
+            {
+                int oneFactor = (state & op.targetMask) ? -1 : 1;
+                backwardStep(pos, state & ~op.targetMask, M_SQRT1_2 * phase);
+                backwardStep(pos, state | op.targetMask, oneFactor * M_SQRT1_2 * phase);
+                return;
+            }
+            case 't':
+            {
+                if ((state & op.controlMask) == op.controlMask) state ^= op.targetMask;
+                break;
+            }
+            case 'p':
+            {
+                if ((state & op.controlMask) == op.controlMask) phase *= op.phase;
+                break;
+            }
+            default: break;
+        }
+    }
+    unordered_map<int, complex<double>>::iterator match = middle.find(state);
+    if (match != middle.end()) joined += match->second * phase;
+}
+
+void meetInMiddle(string gatePath, int n, int startS, int endS, long long memoryBudget, bool showRuntime){
+    N = n;
+    startState = startS, endState = endS;
+    circuit = compileCircuit(gatePath, N);
+    lightCone = lightConeMasks(circuit);
+    
+    int numGates = (int)circuit.size(), hadamards = 0;
+    changesBefore.assign(numGates + 1, 0);
+    for (int g = 0; g < numGates; g++){
+        changesBefore[g + 1] = changesBefore[g] + (circuit[g].gate != 'p');
+        if (circuit[g].gate == 'h') hadamards++;
+    }
+    
+    //choose the forward Hadamard count: at most h/2, with a map of min(2^h_1, 2^n) entries inside the budget
+    int forwardH = 0;
+    while (forwardH < hadamards/2 && (double)ENTRY_BYTES * pow(2, min(forwardH + 1, N)) <= memoryBudget) forwardH++;
+    if (forwardH == 0){
+        cout << "Meet in the middle: memory budget too small, using the linear-space algorithm\n";
+        pathIntegral(gatePath, N, startS, endS, changesBefore.back(), showRuntime);
+        return;
+    }
+    cut = 0;
+    for (int seen = 0; cut < numGates; cut++){ //cut just before the (forwardH + 1)th Hadamard
+        if (circuit[cut].gate == 'h' && seen++ == forwardH) break;
+    }
+    
+    cout << "Main Method: [PocketSimulator, meet in the middle]\n" << N << " qubit simulation in progress........\n";
+    cout << "Cut before gate " << cut << ": " << forwardH << " forward / " << hadamards - forwardH << " backward Hadamards\n";
+    middle.clear();
+    middle.reserve((size_t)min(pow(2, forwardH), pow(2, N)));
+    forwardStep(0, startS, 1);
+    joined = 0;
+    backwardStep(numGates, endS, 1);
+    
+    cout << "<" << binString(endS, N) << "|Circuit|" << binString(startS, N) << "> = " << joined.real() << " + " << joined.imag() << "i\n";
+    
+    if (showRuntime){ //Print time usage
+        cout.precision(7);
+        struct rusage usage;
+        getrusage(RUSAGE_SELF, &usage);
+        long totaluTime = (usage.ru_stime.tv_sec + usage.ru_utime.tv_sec) * 1000000 + usage.ru_stime.tv_usec + usage.ru_utime.tv_usec;
+        double totalTime = totaluTime/ (double) 1000000;
+        cout << "Runtime: " << totalTime << " seconds (" << middle.size() << " intermediate states stored)\n";
+    }
+    cout << "\n";
+    middle = unordered_map<int, complex<double>>(); //release the join table
+}
@@ -0,0 +1,20 @@
+//
+//  meetInMiddle.hpp
+//  PocketSimulator
+//
+//  Created on 10/16/26.
+//  Copyright © 2017. All rights reserved.
+//
+
+#ifndef meetInMiddle_hpp
+#define meetInMiddle_hpp
+
+#include <stdio.h>
+#include <string>
+using namespace std;
+
+/* meetInMiddle: bidirectional path summation of <endState|C|startState> using at most memoryBudget bytes for the hash join.
+ Falls back to pathIntegral when the budget cannot hold a useful forward half. */
+void meetInMiddle(string gatePath, int N, int startState, int endState, long long memoryBudget, bool showRuntime);
+
+#endif /* meetInMiddle_hpp */
@@ -0,0 +1,176 @@
+//
+//  outOfCore.cpp
+//  PocketSimulator
+//
+//  Created on 10/16/26.
+//  Copyright © 2017. All rights reserved.
+//
+#include <iostream>
+#include <complex>
+#include <future>
+#include <algorithm>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/time.h>
+#include <sys/resource.h>
+#include <sys/statvfs.h>
+
+#include "outOfCore.hpp"
+#include "stateVector.hpp"
+#include "gateKernels.hpp"
+#include "gateFusion.hpp"
+#include "cacheBlocking.hpp"
+#include "workPool.hpp"
+#include "circuit.hpp"
+#include "helpers.hpp"
+using namespace std;
+
+//OUT-OF-CORE VARIABLES
+#define MIN_CHUNK_QUBITS 10 //leaves room below the chunk bits for fused gates and the swaps that bring their qubits in
+#define PIPELINE_BUFFERS 3 //one unit being read, one computed, one written
+
+//-----------------------------------OUT-OF-CORE STATE VECTOR--------------------------------
+
+/* The vector is stored as 2^(N-k) chunks of 2^k amplitudes, chunk c holding the indices whose top N - k bits are c, as 2^k real parts
+ followed by 2^k imaginary parts. The circuit is scheduled exactly as for cache blocking (cacheBlocking.cpp), with a chunk as the block:
+ a run of passes that only mix bits below k is one sequential pass over the file, applied chunk by chunk in memory, and a qubit needed
+ inside the chunk is swapped with a chunk bit by a pass over pairs of chunks (c, c + 2^(high - k)), whose halves trade places.
+
+ Every pass over the file is a pipeline of units (a chunk, or a pair of chunks for a swap) over PIPELINE_BUFFERS buffers: while one unit
+ is computed, the next is read and the previous written back by asynchronous pread/pwrite, so the disk stays busy while the gates run.
+ Writes are drained at the end of each pass, since the next pass reads the chunks in a different order. */
+
+struct chunkUnit {
+    long long chunks[2];
+    int count;
+};
+
+bool transferChunk(int fd, double *buffer, long long chunk, long long chunkBytes, bool write){
+    long long done = 0, offset = chunk * chunkBytes;
+    while (done < chunkBytes){
+        ssize_t n = write ? pwrite(fd, (char *)buffer + done, chunkBytes - done, offset + done) : pread(fd, (char *)buffer + done, chunkBytes - done, offset + done);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) return false;
+        done += n;
+    }
+    return true;
+}
+
+bool transferUnit(int fd, double *buffer, chunkUnit unit, long long chunkBytes, bool write){
+    for (int c = 0; c < unit.count; c++){
+        if (!transferChunk(fd, buffer + c * (chunkBytes / sizeof(double)), unit.chunks[c], chunkBytes, write)) return false;
+    }
+    return true;
+}
+
+/* swapHalves: within a pair of chunks (the first with chunk bit 0, the second with 1), swaps index bit 'low' with that chunk bit: the
+ first chunk's amplitudes with bit low = 1 trade places with the second's with bit low = 0 */
+void swapHalves(double *first, double *second, long long chunkSize, int low, int part, int parts){
+    long long run = 1LL << low, runs = chunkSize / (2 * run);
+    for (int k = 0; k < 2; k++){ //real parts, then imaginary parts
+        double *a = first + k * chunkSize, *b = second + k * chunkSize;
+        for (long long r = runs * part / parts; r < runs * (part + 1) / parts; r++){
+            long long start = 2 * r * run;
+            swap_ranges(a + start + run, a + start + 2 * run, b + start);
+        }
+    }
+}
+
+void outOfCoreStateVector(string gatePath, int N, int startState, int endState, int fusionQubits, string vectorPath, long long chunkBytes, int numThreads, bool showRuntime){
+    cout << "Comparison algorithm: [out-of-core stateVector]\n" << N << " qubit simulation in progress........\n";
+    struct timeval wallStart, wallEnd;
+    gettimeofday(&wallStart, NULL);
+    int chunkQubits = MIN_CHUNK_QUBITS;
+    while (chunkQubits < N && (2LL << chunkQubits) * 2 * (long long)sizeof(double) <= chunkBytes) chunkQubits++;
+    chunkQubits = min(chunkQubits, N);
+    long long chunkSize = 1LL << chunkQubits, chunks = 1LL << (N - chunkQubits), fileBytes = 2 * (1LL << N) * (long long)sizeof(double);
+    chunkBytes = 2 * chunkSize * (long long)sizeof(double);
+
+    struct statvfs disk;
+    size_t slash = vectorPath.find_last_of('/');
+    string directory = slash == string::npos ? "." : vectorPath.substr(0, slash + 1);
+    if (statvfs(directory.c_str(), &disk) == 0 && (long long)disk.f_bavail * (long long)disk.f_frsize < fileBytes){
+        cout << "State vector file needs " << fileBytes / 1048576.0 << " MB, but only " << (long long)disk.f_bavail * (long long)disk.f_frsize / 1048576.0 << " MB of disk is free\n\n";
+        return;
+    }
+    int fd = open(vectorPath.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0600);
+    if (fd < 0 || ftruncate(fd, fileBytes) != 0){ //a new file reads as zeros: every amplitude starts at 0
+        cout << "Could not create " << vectorPath << ": " << strerror(errno) << "\n\n";
+        if (fd >= 0) close(fd);
+        return;
+    }
+    unique_ptr<workPool> pool;
+    if (numThreads != 1){
+        pool.reset(new workPool(numThreads));
+        pool->pin();
+    }
+    vector<double *> buffers;
+    for (int b = 0; b < PIPELINE_BUFFERS; b++){
+        double *buffer = allocAmplitudes<double>(2 * chunkSize, false, pool.get()); //room for a pair of chunks
+        if (buffer == NULL) break;
+        buffers.push_back(buffer);
+    }
+    double one = 1;
+    bool ok = (int)buffers.size() == PIPELINE_BUFFERS;
+    ok = ok && pwrite(fd, &one, sizeof(double), ((long long)startState >> chunkQubits) * chunkBytes + (startState & (chunkSize - 1)) * (long long)sizeof(double)) == sizeof(double);
+
+    const gateKernels &kernels = selectKernels<double>(chunkSize);
+    vector<fusedGate> passes = fuseGates(compileCircuit(gatePath, N), N, fusionQubits);
+    vector<int> layout; //layout[b] = the bit of the file index holding index bit b
+    vector<blockStep> steps = scheduleBlocks(passes, N, chunkQubits, layout);
+    long long sweeps = 0, bytesMoved = 0;
+
+    for (int s = 0; s < (int)steps.size() && ok; s++){
+        const blockStep &step = steps[s];
+        vector<chunkUnit> units;
+        for (long long c = 0; c < chunks; c++){
+            if (step.kind == 'b') units.push_back({{c, 0}, 1});
+            else if (!((c >> (step.high - chunkQubits)) & 1)) units.push_back({{c, c | (1LL << (step.high - chunkQubits))}, 2});
+        }
+        future<bool> reading = async(launch::async, transferUnit, fd, buffers[0], units[0], chunkBytes, false), writing;
+        for (int u = 0; u < (int)units.size() && ok; u++){
+            double *buffer = buffers[u % PIPELINE_BUFFERS];
+            ok = reading.get();
+            if (!ok) break;
+            if (u + 1 < (int)units.size()) reading = async(launch::async, transferUnit, fd, buffers[(u + 1) % PIPELINE_BUFFERS], units[u + 1], chunkBytes, false);
+            if (step.kind == 's'){
+                forEachSlice(pool.get(), [&](int part, int parts){ swapHalves(buffer, buffer + 2 * chunkSize, chunkSize, step.low, part, parts); });
+            } else {
+                long long base = units[u].chunks[0] << chunkQubits;
+                for (const fusedGate &pass : step.passes){
+                    forEachSlice(pool.get(), [&](int part, int parts){ applyPass(kernels, pass, buffer, buffer + chunkSize, chunkSize, base, N, part, parts); });
+                }
+            }
+            if (writing.valid()) ok = writing.get();
+            writing = async(launch::async, transferUnit, fd, buffer, units[u], chunkBytes, true);
+            bytesMoved += 2 * units[u].count * chunkBytes;
+        }
+        if (reading.valid()) reading.wait();
+        if (writing.valid()) ok = writing.get() && ok;
+        sweeps++;
+    }
+
+    if (ok){
+        long long end = physicalIndex(endState, layout), at = (end >> chunkQubits) * chunkBytes + (end & (chunkSize - 1)) * (long long)sizeof(double);
+        double endRe = 0, endIm = 0;
+        ok = pread(fd, &endRe, sizeof(double), at) == sizeof(double) && pread(fd, &endIm, sizeof(double), at + chunkSize * (long long)sizeof(double)) == sizeof(double);
+        if (ok) cout << "<" << binString(endState, N) << "|Circuit|" << binString(startState, N) << "> = " << endRe << " + " << endIm << "i\n";
+    }
+    if (!ok) cout << "Out-of-core simulation failed: " << (buffers.size() < PIPELINE_BUFFERS ? "no memory for the chunk buffers" : strerror(errno)) << "\n";
+    if (ok && showRuntime){ //Print time usage (CPU time summed over all threads, and wall-clock time)
+        cout.precision(7);
+        struct rusage usage;
+        getrusage(RUSAGE_SELF, &usage);
+        gettimeofday(&wallEnd, NULL);
+        long totaluTime = (usage.ru_stime.tv_sec + usage.ru_utime.tv_sec) * 1000000 + usage.ru_stime.tv_usec + usage.ru_utime.tv_usec;
+        long wall = (wallEnd.tv_sec - wallStart.tv_sec) * 1000000 + wallEnd.tv_usec - wallStart.tv_usec;
+        cout << "Runtime: " << totaluTime / (double) 1000000 << " seconds (" << chunks << " chunks of " << chunkBytes / 1048576.0 << " MB, " << passes.size() << " passes in "
+             << sweeps << " sweeps over the file, " << bytesMoved / 1073741824.0 << " GB read and written, wall clock " << wall / (double) 1000000 << " seconds)\n";
+    }
+    cout << "\n";
+    for (double *buffer : buffers) free(buffer);
+    close(fd);
+    unlink(vectorPath.c_str());
+}
@@ -0,0 +1,21 @@
+//
+//  outOfCore.hpp
+//  PocketSimulator
+//
+//  Created on 10/16/26.
+//  Copyright © 2017. All rights reserved.
+//
+
+#ifndef outOfCore_hpp
+#define outOfCore_hpp
+
+#include <stdio.h>
+#include <string>
+using namespace std;
+
+/* outOfCoreStateVector: the state vector algorithm with the amplitudes kept in the file vectorPath instead of memory, for vectors larger
+ than RAM. The file is split into chunks of (at most) chunkBytes; only a few chunks are in memory at once, and the file is deleted at the
+ end. numThreads threads apply the gates to the chunk in memory (<= 0: all cores). */
+void outOfCoreStateVector(string gatePath, int N, int startState, int endState, int fusionQubits, string vectorPath, long long chunkBytes, int numThreads, bool showRuntime);
+
+#endif /* outOfCore_hpp */
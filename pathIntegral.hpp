@@ -10,10 +10,55 @@
 #define pathIntegral_hpp
 
 #include <stdio.h>
+#include <vector>
+#include "circuit.hpp"
 using namespace std;
 
-void complexPathStep(streampos pos, int changesLeft, complex<double> currPhase, int currDepth);
+/* basicPathFrame: a pending branch of the iterative engines (next gate to apply, basis state of type S before it, phase so far) */
+template <typename S>
+struct basicPathFrame {
+    int pos;
+    S state;
+    complex<double> phase;
+};
+typedef basicPathFrame<int> pathFrame;
+
+/* pathTask: the subtree of the path tree below a fixed prefix of Hadamard branch choices.
+ pos is the index of the next unprocessed gate; state/phase/changesLeft are the path values at that point. */
+struct pathTask {
+    int pos, state, changesLeft;
+    complex<double> phase;
+};
+
+void complexPathStep(int pos, int changesLeft, complex<double> currPhase, int currDepth);
 
 void pathIntegral(string gatePath, int N, int startState, int endState, int numChanges, bool showRuntime);
 
+/* prefixTask: the subtree below the prefix-th combination of the first 'levels' Hadamard branch choices (false if it is pruned) */
+bool prefixTask(long long prefix, int levels, int startState, int numChanges, pathTask &task);
+
+/* parallelPathIntegral: pathIntegral with the path tree explored by a work-stealing pool of numThreads workers (<= 0: all cores) */
+void parallelPathIntegral(string gatePath, int N, int startState, int endState, int numChanges, int numThreads, bool showRuntime);
+
+/* batchPathIntegral: computes <y|C|startState> for every y in endStates with a single traversal of the path tree (results in the order of endStates) */
+vector<complex<double>> batchPathIntegral(string gatePath, int N, int startState, vector<int> endStates, int numChanges, bool showRuntime);
+
+/* exactPathIntegral: pathIntegral with integer phase exponents along paths and a single conversion to complex at the end */
+void exactPathIntegral(string gatePath, int N, int startState, int endState, int numChanges, bool showRuntime);
+
+/* cachedPathIntegral: pathIntegral with a transposition cache of subtree amplitudes limited to cacheBytes of memory */
+void cachedPathIntegral(string gatePath, int N, int startState, int endState, long long cacheBytes, bool showRuntime);
+
+/* iterativePathSum: <endS|circuit|startS> summed on an explicit frame stack, for basis states of type S (int, or wider for widePath.cpp).
+ lightCone is lightConeMasks(circuit) and changesAfter[g] the # of Hadamards and Toffolis at gate index g or later; nodes counts the
+ Hadamard/Toffoli visits. */
+template <typename S>
+complex<double> iterativePathSum(const vector<basicGateOp<S>> &circuit, const vector<S> &lightCone, const vector<int> &changesAfter, S startS, S endS, long long &nodes);
+
+/* iterativePathIntegral: pathIntegral on an explicit frame stack (no recursion, no limit on the # of Hadamards) */
+void iterativePathIntegral(string gatePath, int N, int startState, int endState, bool showRuntime);
+
+/* benchmarkPathEngines: compares the recursive and iterative engines in nodes/second over the given # of runs */
+void benchmarkPathEngines(string gatePath, int N, int startState, int endState, int repeats);
+
 #endif /* pathIntegral_hpp */
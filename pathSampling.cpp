@@ -0,0 +1,129 @@
+//
+//  pathSampling.cpp
+//  PocketSimulator
+//
+//  Created on 10/16/26.
+//  Copyright © 2017. All rights reserved.
+//
+#include <iostream>
+#include <complex>
+#include <fstream>
+#include <random>
+#include <time.h>
+#include <sys/time.h>
+#include <sys/resource.h>
+#include <math.h>
+#define _USE_MATH_DEFINES
+
+#include "pathSampling.hpp"
+#include "circuit.hpp"
+#include "helpers.hpp"
+using namespace std;
+
+//SAMPLING VARIABLES
+#define SAMPLE_BATCH 4096 //paths drawn between checks of the time budget and standard error
+#define MIN_SAMPLES 65536 //the standard error is not trusted as a stopping rule before this many paths
+extern int N;
+extern int startState, endState;
+extern vector<gateOp> circuit;
+extern vector<int> lightCone, changesAfter;
+void countSuffixes();
+
+//-----------------------------MONTE CARLO PATH INTEGRAL SAMPLING--------------------------
+
+/* When the full sum is out of reach, the amplitude is estimated from random paths. A path is drawn by choosing a branch at every Hadamard
+ and is evaluated with the same gate logic as complexPathStep. If the path's branches were drawn with probability q and it ends in
+ endState with amplitude a (a = 0 otherwise), X = a/q is an unbiased estimate of <endState|C|startState>, since the expected value of X
+ is the sum of a over all paths. The estimate is the mean of X and its standard error is sqrt(Var(X)/samples).
+ 
+ Uniform sampling takes each branch with probability 1/2 (q = 2^-h). Weighted sampling looks one gate ahead: a branch from which the end
+ state can no longer be reached (light cone or bit difference, as in the exact engines) contributes nothing, so the other branch is taken
+ with probability 1. Paths are then drawn only from the part of the tree that can reach endState, which lowers the variance without
+ biasing the estimate. */
+
+bool sampleReachable(int state, int pos){
+    return !((state ^ endState) & ~lightCone[pos]) && bitDiff(state, endState) <= changesAfter[pos];
+}
+
+complex<double> samplePath(mt19937_64 &rng, bool weighted){
+    int numGates = (int)circuit.size(), state = startState, bitsLeft = 0;
+    unsigned long long bits = 0;
+    complex<double> weight = 1; //a/q so far
+    if (!sampleReachable(state, 0)) return 0;
+    for (int pos = 0; pos < numGates; pos++){
+        const gateOp &op = circuit[pos];
+        if (op.gate == 'p'){
+            if ((state & op.controlMask) == op.controlMask) weight *= op.phase;
+            continue;
+        }
+        if (op.gate == 'h'){
+            int oneFactor = (state & op.targetMask) ? -1 : 1, branch;
+            bool zeroOk = true, oneOk = true;
+            if (weighted){
+                zeroOk = sampleReachable(state & ~op.targetMask, pos + 1);
+                oneOk = sampleReachable(state | op.targetMask, pos + 1);
+                if (!zeroOk && !oneOk) return 0;
+            }
+            if (zeroOk && oneOk){ //fair coin: 1/q doubles
+                if (bitsLeft == 0) bits = rng(), bitsLeft = 64;
+                branch = bits & 1;
+                bits >>= 1, bitsLeft--;
+                weight *= 2 * M_SQRT1_2;
+            } else { //forced branch
+                branch = oneOk;
+                weight *= M_SQRT1_2;
+            }
+            if (branch){
+                state |= op.targetMask;
+                weight *= oneFactor;
+            } else state &= ~op.targetMask;
+        } else if ((state & op.controlMask) == op.controlMask) state ^= op.targetMask; //Toffoli
+        if (!sampleReachable(state, pos + 1)) return 0; //can no longer reach the end state: a = 0
+    }
+    return state == endState ? weight : 0;
+}
+
+void sampledPathIntegral(string gatePath, int n, int startS, int endS, double timeBudget, double targetError, bool weighted, unsigned int seed, bool showRuntime){
+    cout << "Main Method: [PocketSimulator, Monte Carlo" << (weighted ? ", reachability-weighted" : "") << "]\n" << n << " qubit simulation in progress........\n";
+    startState = startS, endState = endS;
+    N = n;
+    circuit = compileCircuit(gatePath, N);
+    lightCone = lightConeMasks(circuit);
+    countSuffixes();
+    
+    mt19937_64 rng(seed);
+    complex<double> sum = 0;
+    double sumSquares = 0, error = 0;
+    long long samples = 0;
+    struct timeval start, now;
+    gettimeofday(&start, NULL);
+    while (true){
+        for (int i = 0; i < SAMPLE_BATCH; i++){
+            complex<double> x = samplePath(rng, weighted);
+            sum += x;
+            sumSquares += norm(x);
+        }
+        samples += SAMPLE_BATCH;
+        complex<double> mean = sum / (double)samples;
+        error = sqrt(max(sumSquares / samples - norm(mean), 0.0) / (samples - 1)); //standard error of the mean
+        gettimeofday(&now, NULL);
+        double elapsed = (now.tv_sec - start.tv_sec) + (now.tv_usec - start.tv_usec) / (double) 1000000;
+        if (timeBudget > 0 && elapsed >= timeBudget) break;
+        if (targetError > 0 && samples >= MIN_SAMPLES && error <= targetError) break;
+        if (timeBudget <= 0 && targetError <= 0) break; //no stopping rule: a single batch
+    }
+    
+    complex<double> result = sum / (double)samples;
+    cout << "<" << binString(endS, N) << "|Circuit|" << binString(startS, N) << "> = " << result.real() << " + " << result.imag() << "i\n";
+    cout << "Standard error: " << error << " (95% interval: estimate +- " << 1.96 * error << "), " << samples << " samples\n";
+    
+    if (showRuntime){ //Print time usage
+        cout.precision(7);
+        struct rusage usage;
+        getrusage(RUSAGE_SELF, &usage);
+        long totaluTime = (usage.ru_stime.tv_sec + usage.ru_utime.tv_sec) * 1000000 + usage.ru_stime.tv_usec + usage.ru_utime.tv_usec;
+        double totalTime = totaluTime/ (double) 1000000;
+        cout << "Runtime: " << totalTime << " seconds\n";
+    }
+    cout << "\n";
+}
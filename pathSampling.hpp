@@ -0,0 +1,21 @@
+//
+//  pathSampling.hpp
+//  PocketSimulator
+//
+//  Created on 10/16/26.
+//  Copyright © 2017. All rights reserved.
+//
+
+#ifndef pathSampling_hpp
+#define pathSampling_hpp
+
+#include <stdio.h>
+#include <string>
+using namespace std;
+
+/* sampledPathIntegral: Monte Carlo estimate of <endState|C|startState> from randomly drawn paths, printed with its standard error.
+ Sampling stops after timeBudget seconds or once the standard error is at most targetError (either one <= 0 is ignored);
+ weighted = draw only branches from which the end state is still reachable. */
+void sampledPathIntegral(string gatePath, int N, int startState, int endState, double timeBudget, double targetError, bool weighted, unsigned int seed, bool showRuntime);
+
+#endif /* pathSampling_hpp */
@@ -0,0 +1,285 @@
+//
+//  rankTransport.cpp
+//  PocketSimulator
+//
+//  Created on 10/16/26.
+//  Copyright © 2017. All rights reserved.
+//
+#include <iostream>
+#include <vector>
+#include <atomic>
+#include <thread>
+#include <chrono>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+
+#include "rankTransport.hpp"
+using namespace std;
+
+#define CONNECT_SECONDS 30 //how long a rank waits for the others to start
+#define SHM_SLOT_BYTES (1LL << 20) //each rank's mailbox in the shared segment: exchanges larger than this go through it in pieces
+#define SHM_READY 0x5053494d //'PSIM': the segment has been initialized by rank 0
+
+//------------------------------------SHARED MEMORY------------------------------------------
+
+/* One segment holds a barrier and a mailbox per rank. A rank posts a piece of its send buffer in its own mailbox, addressed to its partner,
+ and takes its partner's piece from the partner's mailbox; it posts the next piece once its partner has taken the last one. Every mailbox
+ has a single writer, and a piece has a single reader, so the counters need no locks. Waiting ranks yield the core, since ranks may
+ outnumber cores. Rank 0 unlinks the segment's name once every rank has attached, so a crashed run leaves nothing behind. */
+
+struct shmHeader {
+    atomic<int> ready, arrived, generation;
+};
+
+struct alignas(64) shmMailbox {
+    atomic<long long> posted, taken; //pieces posted by the owner / taken by their readers
+    atomic<int> to; //the rank the last posted piece is for
+};
+
+class shmTransport : public rankTransport {
+public:
+    shmTransport(int rank, int ranks) : rankTransport(rank, ranks), memory(NULL), bytes(0) {}
+    ~shmTransport(){
+        if (memory != NULL) munmap(memory, bytes);
+    }
+
+    bool attach(string name){
+        string path = "/" + name;
+        bytes = sizeof(shmHeader) + 64 + rankCount * (sizeof(shmMailbox) + SHM_SLOT_BYTES);
+        int fd = -1;
+        if (myRank == 0){
+            shm_unlink(path.c_str()); //a segment left over by an earlier run
+            fd = shm_open(path.c_str(), O_CREAT | O_EXCL | O_RDWR, 0600);
+            if (fd < 0 || ftruncate(fd, bytes) != 0){
+                cout << "Could not create shared memory " << path << ": " << strerror(errno) << "\n";
+                if (fd >= 0) close(fd);
+                return false;
+            }
+        } else {
+            auto deadline = chrono::steady_clock::now() + chrono::seconds(CONNECT_SECONDS);
+            struct stat info;
+            while ((fd = shm_open(path.c_str(), O_RDWR, 0600)) < 0 || fstat(fd, &info) != 0 || info.st_size < bytes){
+                if (fd >= 0) close(fd);
+                if (chrono::steady_clock::now() > deadline){
+                    cout << "Rank " << myRank << " timed out waiting for shared memory " << path << "\n";
+                    return false;
+                }
+                this_thread::sleep_for(chrono::milliseconds(10));
+            }
+        }
+        memory = mmap(NULL, bytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        close(fd);
+        if (memory == MAP_FAILED){
+            memory = NULL;
+            cout << "Could not map shared memory " << path << ": " << strerror(errno) << "\n";
+            return false;
+        }
+        header = (shmHeader *)memory;
+        mailboxes = (shmMailbox *)((char *)memory + 64);
+        slots = (char *)(mailboxes + rankCount);
+        if (myRank == 0) header->ready.store(SHM_READY, memory_order_release); //the new segment is zeroed: counters start at 0
+        else while (header->ready.load(memory_order_acquire) != SHM_READY) this_thread::yield();
+        barrier();
+        if (myRank == 0) shm_unlink(path.c_str());
+        return true;
+    }
+
+    bool exchange(int partner, const void *send, void *receive, long long count){
+        shmMailbox &mine = mailboxes[myRank], &theirs = mailboxes[partner];
+        char *mySlot = slots + myRank * SHM_SLOT_BYTES, *theirSlot = slots + partner * SHM_SLOT_BYTES;
+        for (long long offset = 0; offset < count; offset += SHM_SLOT_BYTES){
+            long long n = min((long long)SHM_SLOT_BYTES, count - offset);
+            while (mine.taken.load(memory_order_acquire) != mine.posted.load(memory_order_relaxed)) this_thread::yield();
+            memcpy(mySlot, (const char *)send + offset, n);
+            mine.to.store(partner, memory_order_release);
+            mine.posted.fetch_add(1, memory_order_release);
+            while (theirs.posted.load(memory_order_acquire) == theirs.taken.load(memory_order_acquire) || theirs.to.load(memory_order_acquire) != myRank){
+                this_thread::yield();
+            }
+            memcpy((char *)receive + offset, theirSlot, n);
+            theirs.taken.fetch_add(1, memory_order_release);
+        }
+        return true;
+    }
+
+    void barrier(){
+        int generation = header->generation.load(memory_order_acquire);
+        if (header->arrived.fetch_add(1, memory_order_acq_rel) == rankCount - 1){
+            header->arrived.store(0, memory_order_relaxed);
+            header->generation.fetch_add(1, memory_order_release);
+            return;
+        }
+        while (header->generation.load(memory_order_acquire) == generation) this_thread::yield();
+    }
+
+    const char *name(){ return "shared memory"; }
+
+private:
+    void *memory;
+    long long bytes;
+    shmHeader *header;
+    shmMailbox *mailboxes;
+    char *slots;
+};
+
+//-------------------------------------UNIX SOCKETS------------------------------------------
+
+/* Every pair of ranks shares a stream socket: rank r listens on path.r, connects to every lower rank's socket (sending its rank number
+ first) and accepts the higher ranks, all within CONNECT_SECONDS. An exchange sends and receives at once (polling the socket both
+ ways), so two ranks sending each other more than the socket buffers hold cannot deadlock. The barrier gathers one byte at rank 0,
+ which then releases every rank. */
+
+class socketTransport : public rankTransport {
+public:
+    socketTransport(int rank, int ranks) : rankTransport(rank, ranks), sockets(ranks, -1), listener(-1) {}
+    ~socketTransport(){
+        for (int fd : sockets) if (fd >= 0) close(fd);
+        if (listener >= 0){
+            close(listener);
+            unlink(ownPath.c_str());
+        }
+    }
+
+    bool connectAll(string path){
+        ownPath = path + "." + to_string(myRank);
+        struct sockaddr_un address;
+        if (!socketAddress(ownPath, address)) return false;
+        unlink(ownPath.c_str());
+        listener = socket(AF_UNIX, SOCK_STREAM, 0);
+        if (listener < 0 || ::bind(listener, (struct sockaddr *)&address, sizeof(address)) != 0 || listen(listener, rankCount) != 0){
+            cout << "Rank " << myRank << " could not listen on " << ownPath << ": " << strerror(errno) << "\n";
+            return false;
+        }
+        auto deadline = chrono::steady_clock::now() + chrono::seconds(CONNECT_SECONDS);
+        for (int p = 0; p < myRank; p++){
+            string peerPath = path + "." + to_string(p);
+            if (!socketAddress(peerPath, address)) return false;
+            while (true){
+                int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+                if (fd >= 0 && connect(fd, (struct sockaddr *)&address, sizeof(address)) == 0){
+                    sockets[p] = fd;
+                    break;
+                }
+                if (fd >= 0) close(fd);
+                if (chrono::steady_clock::now() > deadline){
+                    cout << "Rank " << myRank << " timed out connecting to " << peerPath << "\n";
+                    return false;
+                }
+                this_thread::sleep_for(chrono::milliseconds(10));
+            }
+            if (!transfer(sockets[p], &myRank, sizeof(int), NULL, 0)) return false;
+        }
+        for (int accepted = myRank + 1; accepted < rankCount; accepted++){
+            struct pollfd waiting = {listener, POLLIN, 0};
+            int ready, left;
+            do {
+                left = (int)chrono::duration_cast<chrono::milliseconds>(deadline - chrono::steady_clock::now()).count();
+                ready = left > 0 ? poll(&waiting, 1, left) : 0;
+            } while (ready < 0 && errno == EINTR);
+            if (ready <= 0){ //a higher rank never connected (it may have died before it could)
+                cout << "Rank " << myRank << " timed out waiting for higher ranks to connect to " << ownPath << "\n";
+                return false;
+            }
+            int fd = accept(listener, NULL, NULL), peer = -1;
+            if (fd < 0 || !transfer(fd, NULL, 0, &peer, sizeof(int)) || peer <= myRank || peer >= rankCount || sockets[peer] >= 0){
+                cout << "Rank " << myRank << " got a bad connection on " << ownPath << "\n";
+                if (fd >= 0) close(fd);
+                return false;
+            }
+            sockets[peer] = fd;
+        }
+        return true;
+    }
+
+    bool exchange(int partner, const void *send, void *receive, long long count){
+        return transfer(sockets[partner], send, count, receive, count);
+    }
+
+    void barrier(){
+        char token = 0;
+        if (myRank != 0){
+            transfer(sockets[0], &token, 1, NULL, 0);
+            transfer(sockets[0], NULL, 0, &token, 1);
+            return;
+        }
+        for (int p = 1; p < rankCount; p++) transfer(sockets[p], NULL, 0, &token, 1);
+        for (int p = 1; p < rankCount; p++) transfer(sockets[p], &token, 1, NULL, 0);
+    }
+
+    const char *name(){ return "Unix sockets"; }
+
+private:
+    vector<int> sockets; //sockets[p]: the connection to rank p
+    int listener;
+    string ownPath;
+
+    bool socketAddress(string path, struct sockaddr_un &address){
+        memset(&address, 0, sizeof(address));
+        address.sun_family = AF_UNIX;
+        if (path.size() >= sizeof(address.sun_path)){
+            cout << "Socket path " << path << " is too long\n";
+            return false;
+        }
+        strcpy(address.sun_path, path.c_str());
+        return true;
+    }
+
+    /* transfer: sends sendBytes from send while receiving receiveBytes into receive, on one socket */
+    bool transfer(int fd, const void *send, long long sendBytes, void *receive, long long receiveBytes){
+        long long sent = 0, received = 0;
+        while (sent < sendBytes || received < receiveBytes){
+            struct pollfd wait = {fd, (short)((sent < sendBytes ? POLLOUT : 0) | (received < receiveBytes ? POLLIN : 0)), 0};
+            if (poll(&wait, 1, -1) < 0){
+                if (errno == EINTR) continue;
+                return false;
+            }
+            if ((wait.revents & POLLOUT) && sent < sendBytes){
+                ssize_t n = ::send(fd, (const char *)send + sent, sendBytes - sent, MSG_DONTWAIT | MSG_NOSIGNAL);
+                if (n < 0 && errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR) return false;
+                if (n > 0) sent += n;
+            }
+            if ((wait.revents & (POLLIN | POLLHUP)) && received < receiveBytes){
+                ssize_t n = recv(fd, (char *)receive + received, receiveBytes - received, MSG_DONTWAIT);
+                if (n == 0 || (n < 0 && errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR)){
+                    cout << "Rank " << myRank << " lost its connection\n";
+                    return false;
+                }
+                if (n > 0) received += n;
+            }
+            if ((wait.revents & (POLLERR | POLLNVAL)) && !(wait.revents & POLLIN)) return false;
+        }
+        return true;
+    }
+};
+
+//---------------------------------------OPENING---------------------------------------------
+
+rankTransport *openTransport(string spec, int rank, int ranks){
+    size_t colon = spec.find(':');
+    string kind = spec.substr(0, colon), where = colon == string::npos ? "" : spec.substr(colon + 1);
+    if (ranks < 1 || rank < 0 || rank >= ranks || where.empty()){
+        cout << "Expected transport shm:name or socket:path, and rank 0 <= i < k\n";
+        return NULL;
+    }
+    if (kind == "shm"){
+        shmTransport *transport = new shmTransport(rank, ranks);
+        if (transport->attach(where)) return transport;
+        delete transport;
+        return NULL;
+    }
+    if (kind == "socket"){
+        socketTransport *transport = new socketTransport(rank, ranks);
+        if (transport->connectAll(where)) return transport;
+        delete transport;
+        return NULL;
+    }
+    cout << "Unknown transport " << kind << " (expected shm or socket)\n";
+    return NULL;
+}
@@ -0,0 +1,43 @@
+//
+//  rankTransport.hpp
+//  PocketSimulator
+//
+//  Created on 10/16/26.
+//  Copyright © 2017. All rights reserved.
+//
+
+#ifndef rankTransport_hpp
+#define rankTransport_hpp
+
+#include <stdio.h>
+#include <string>
+using namespace std;
+
+/* rankTransport: how the ranks (processes) of a distributed simulation talk to each other. Ranks only ever exchange equal-sized buffers
+ in pairs, so a transport needs just a symmetric pairwise exchange and a barrier; a transport across nodes (e.g. TCP or MPI) is one more
+ subclass, returned by openTransport for its own prefix. */
+class rankTransport {
+public:
+    rankTransport(int rank, int ranks) : myRank(rank), rankCount(ranks) {}
+    virtual ~rankTransport() {}
+
+    /* exchange: sends 'bytes' bytes from 'send' to rank 'partner' and receives the same number of bytes from it into 'receive' (the partner
+     calls exchange with this rank at the same time). send and receive must not overlap. Returns false if the partner is gone. */
+    virtual bool exchange(int partner, const void *send, void *receive, long long bytes) = 0;
+    virtual void barrier() = 0; //returns once every rank has called barrier()
+    virtual const char *name() = 0;
+
+    int rank() { return myRank; }
+    int ranks() { return rankCount; }
+
+protected:
+    int myRank, rankCount;
+};
+
+/* openTransport: connects rank 'rank' of 'ranks' to the others, as given by spec:
+ shm:name  POSIX shared memory segment /name (one host); every rank of a run must use the same name, and no other run may use it at the same time
+ socket:path  Unix domain sockets path.0, path.1, ... (one host)
+ Returns NULL (with the reason printed) if the spec is unknown or the connection fails. */
+rankTransport *openTransport(string spec, int rank, int ranks);
+
+#endif /* rankTransport_hpp */
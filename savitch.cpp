@@ -14,17 +14,32 @@
 #include <math.h>
 #define _USE_MATH_DEFINES
 #define MAX_LAYERS 1000 //Set a cap on the maximum simulation layer count
+#define PHASE_TABLE_BITS 8 //qubits per phase table of a compiled layer (2^8 precomputed phases)
 
 #include "helpers.hpp"
 #include "savitch.hpp"
+#include "circuit.hpp"
 
 using namespace std;
 
+/* savitchLayer: a layer compiled once for the base case. Within a layer no qubit is acted on twice, so its gates commute and each reads
+ its qubits straight from the start state: the Hadamards are one mask, the Toffolis (control mask, target mask) pairs, and the phase
+ gates are folded into tables of the product of their phases, each indexed by up to PHASE_TABLE_BITS of the start state's bits. */
+struct phaseTable {
+    vector<int> bits; //bit positions of the table index, lowest first
+    vector<complex<double>> phases;
+};
+
+struct savitchLayer {
+    int hadamardMask;
+    double hadamardScale; //(1/sqrt(2))^(# of Hadamards)
+    vector<pair<int, int>> toffolis;
+    vector<phaseTable> tables;
+};
+
 //AARONSON VARIABLES
-bool bitReached[32];
-string layerGates[MAX_LAYERS];
+vector<savitchLayer> compiledLayers;
 int layers[MAX_LAYERS];
-extern ifstream in;
 
 //----------------------------------AARONSON RECURSION-------------------------------------
 
@@ -42,83 +57,26 @@ extern ifstream in;
 complex<double> savitchRecur(int N, int beginD, int endD, int startS, int endS, int *layers, bool verbose){ //Recursive subalgorithm for algorithm three
     complex<double> result = complex<double>(0);
     if (verbose) cout << beginD << "(" << startS << ") to " << endD << "(" << endS << ")\n";
-    if (beginD == endD) { //base case
-        result = 1;
-        in.clear();
-        in.seekg(ios::beg);
-        stringstream gates;
-        gates << layerGates[beginD];
-        
-        char gate;
-        int c1, c2, target, endBit, control, c;
-        int qubits = startS;
-        int phasePow;
-        
-        gates >> control >> gate;
-        while (!gates.eof()){ //act on gates inside this layer
-            switch (gate){
-                case 'h': //hadamard
-                {
-                    gates >> target;
-                    endBit = (endS >> (N - target - 1)) & 1;
-                    if ((((qubits >> (N - target - 1)) & 1) == 1) && endBit == 1){
-                        //if the hadamarded bit is 1 in both the start and end states, the end amplitude will be negative
-                        result *= -1;
-                    }
-                    //set the hadamarded bit in the register (qubits) to whatever it equals in the end state
-                    qubits = qubits & ~(1 << (N - target - 1));
-                    qubits += (endBit << (N - target - 1));
-                    result /= sqrt(2); //hadamard-adjusted amplitude
-                    break;
-                }
-                case 't': //toffoli
-                {
-                    gates >> c1 >> c2 >> target;
-                    int add = ((qubits >> (N - c1 - 1)) & 1) * ((qubits >> (N - c2 - 1)) & 1);
-                    qubits = qubits ^ (add << (N - target - 1)); //update register
-                    break;
-                }
-                case 'U':
-                {
-                    gates >> phasePow;
-                    complex<double> phase = polar(1.0, 1/pow(2, phasePow) * 2 * M_PI);
-                    if (control){ // controlled gate case
-                        gates >> c >> target;
-                        if (((qubits >> (N - c - 1)) & 1) && ((qubits >> (N - target - 1)) & 1)) result *= phase;
-                    } else { // non-controlled gate case
-                        gates >> target;
-                        if ((qubits >> (N - target - 1)) & 1) result *= phase;
-                    }
-                    break;
-                }
-                case 'u':
-                {
-                    gates >> phasePow;
-                    complex<double> phase = polar(1.0, -1/pow(2, phasePow) * 2 * M_PI);
-                    if (control){ // controlled gate case
-                        gates >> c >> target;
-                        if (((qubits >> (N - c - 1)) & 1) && ((qubits >> (N - target - 1)) & 1)) result *= phase;
-                    } else { // non-controlled gate case
-                        gates >> target;
-                        if ((qubits >> (N - target - 1)) & 1) result *= phase;
-                    }
-                    break;
-                }
-                default:
-                {
-                    cout << "Incompatible gate type: " << gate << "\n";
-                    break;
-                }
-            }
-            gates >> control >> gate;
-        }
+    if (beginD == endD) { //base case: <endS|Layer|startS>
+        const savitchLayer &layer = compiledLayers[beginD];
+        //each hadamarded bit is set to whatever it equals in the end state; the Toffolis then flip their targets
+        int qubits = (startS & ~layer.hadamardMask) | (endS & layer.hadamardMask);
+        for (const pair<int, int> &toffoli : layer.toffolis) if ((startS & toffoli.first) == toffoli.first) qubits ^= toffoli.second;
         // <endS|qubits> == 0 if endS ≠ qubits [|qubits> = Layer|startS>]
-        if (qubits != endS) result = 0;
+        if (qubits != endS) return result;
+        //if the hadamarded bit is 1 in both the start and end states, the end amplitude will be negative
+        result = __builtin_parity(startS & endS & layer.hadamardMask) ? -layer.hadamardScale : layer.hadamardScale;
+        for (const phaseTable &table : layer.tables){
+            int index = 0;
+            for (int j = 0; j < (int)table.bits.size(); j++) index |= ((startS >> table.bits[j]) & 1) << j;
+            result *= table.phases[index];
+        }
         return result;
     } else { //recursive case
         /* Compute <y|C|x> by summing all <y|C_1|i><i|C_2|x> for i = {0,1}^n.
          Compute the two sub terms recursively. */
-        for (int i = 0; i < pow(2, N); i++){
+        for (long long middle = 0; middle < (1LL << N); middle++){ //64-bit counter: 2^31 states do not fit an int at N = MAX_INT_QUBITS
+            int i = (int)middle;
             if (bitDiff(startS, i) <= (layers[(beginD + endD)/2 + 1] - layers[beginD]) &&
                 bitDiff(i, endS) <= (layers[endD + 1] - layers[(beginD + endD)/2 + 1])){
                 complex<double> termOne = savitchRecur(N, beginD, (beginD + endD)/2, startS, i, layers, verbose);
@@ -131,121 +89,63 @@ complex<double> savitchRecur(int N, int beginD, int endD, int startS, int endS,
     return result;
 }
 
+/* compileLayer: the base case form of a layer's gates */
+savitchLayer compileLayer(const vector<gateOp> &gates){
+    savitchLayer layer = {0, 1, {}, {}};
+    vector<const gateOp *> phases;
+    for (const gateOp &op : gates){
+        switch (op.gate){
+            case 'h': layer.hadamardMask |= op.targetMask, layer.hadamardScale *= M_SQRT1_2; break;
+            case 't': layer.toffolis.push_back(make_pair(op.controlMask, op.targetMask)); break;
+            case 'p': phases.push_back(&op); break;
+            default: break;
+        }
+    }
+    for (int first = 0; first < (int)phases.size(); ){ //group the phase gates into tables of at most PHASE_TABLE_BITS bits
+        int mask = 0, last = first;
+        while (last < (int)phases.size() && __builtin_popcount(mask | phases[last]->controlMask) <= PHASE_TABLE_BITS) mask |= phases[last++]->controlMask;
+        phaseTable table;
+        for (int b = 0; b < 32; b++) if ((mask >> b) & 1) table.bits.push_back(b);
+        table.phases.assign(1 << table.bits.size(), 1);
+        for (int index = 0; index < (int)table.phases.size(); index++){
+            int state = 0;
+            for (int j = 0; j < (int)table.bits.size(); j++) state |= ((index >> j) & 1) << table.bits[j];
+            for (int g = first; g < last; g++) if ((state & phases[g]->controlMask) == phases[g]->controlMask) table.phases[index] *= phases[g]->phase;
+        }
+        layer.tables.push_back(table);
+        first = last;
+    }
+    return layer;
+}
+
 void savitch(string gatePath, int N, int startState, int endState, bool verbose, bool showRuntime){
     cout << "Comparison algorithm: [Aaronson's Savitch]\n" << N << " qubit simulation in progress........\n";
-    char gate;
-    int c1, c2, target, depth = 0, gCount = 0, ctrl, c;
-    string gateBuffer = "";
-    int phasePow;
+    vector<gateOp> circuit = compileCircuit(gatePath, N);
+    vector<gateOp> layerOps;
+    int depth = 0, reached = 0; //reached: the qubits acted on in the current layer
     
-    in = ifstream(gatePath);
-    in.clear();
-    in.seekg(ios::beg);
-    in >> ctrl >> gate;
-    resetCounter(bitReached, N);
+    compiledLayers.clear();
     layers[0] = 0;
-    while (!in.eof()){ //separate circuit into layers, record layer dividers in layers[], record gate sequences in layerGates[]
-        switch (gate){
-            case 'h':
-            {
-                in >> target;
-                if (bitReached[target]){
-                    layerGates[depth] = gateBuffer;
-                    depth++;
-                    layers[depth] = gCount;
-                    resetCounter(bitReached, N);
-                    gateBuffer = "";
-                }
-                bitReached[target] = true;
-                gateBuffer = gateBuffer + "0 h " + to_string(target) + " ";
-                break;
-            }
-            case 't':
-            {
-                in >> c1 >> c2 >> target;
-                if (bitReached[c1] || bitReached[c2] || bitReached[target]){
-                    layerGates[depth] = gateBuffer;
-                    depth++;
-                    layers[depth] = gCount;
-                    resetCounter(bitReached, N);
-                    gateBuffer = "";
-                }
-                bitReached[c1] = true;
-                bitReached[c2] = true;
-                bitReached[target] = true;
-                gateBuffer = gateBuffer + "0 t " + to_string(c1) + " " + to_string(c2) + " " +to_string(target) + " ";
-                break;
-            }
-            case 'U':
-            {
-                in >> phasePow;
-                if (ctrl){ // controlled gate case
-                    in >> c >> target;
-                    if (bitReached[c] || bitReached[target]){
-                        layerGates[depth] = gateBuffer;
-                        depth++;
-                        layers[depth] = gCount;
-                        resetCounter(bitReached, N);
-                        gateBuffer = "";
-                    }
-                    bitReached[c] = true;
-                    bitReached[target] = true;
-                    gateBuffer = gateBuffer + "1 U " + to_string(phasePow) + " " + to_string(c) + " " +to_string(target) + " ";
-                } else { // non-controlled gate case
-                    in >> target;
-                    if (bitReached[target]){
-                        layerGates[depth] = gateBuffer;
-                        depth++;
-                        layers[depth] = gCount;
-                        resetCounter(bitReached, N);
-                        gateBuffer = "";
-                    }
-                    bitReached[target] = true;
-                    gateBuffer = gateBuffer + "0 U " + to_string(phasePow) + " " +to_string(target) + " ";
-                }
-                break;
-            }
-            case 'u':
-            {
-                in >> phasePow;
-                if (ctrl){ // controlled gate case
-                    in >> c >> target;
-                    if (bitReached[c] || bitReached[target]){
-                        layerGates[depth] = gateBuffer;
-                        depth++;
-                        layers[depth] = gCount;
-                        resetCounter(bitReached, N);
-                        gateBuffer = "";
-                    }
-                    bitReached[c] = true;
-                    bitReached[target] = true;
-                    gateBuffer = gateBuffer + "1 u " + to_string(phasePow) + " " + to_string(c) + " " +to_string(target) + " ";
-                } else { // non-controlled gate case
-                    in >> target;
-                    if (bitReached[target]){
-                        layerGates[depth] = gateBuffer;
-                        depth++;
-                        layers[depth] = gCount;
-                        resetCounter(bitReached, N);
-                        gateBuffer = "";
-                    }
-                    bitReached[target] = true;
-                    gateBuffer = gateBuffer + "0 u " + to_string(phasePow) + " " +to_string(target) + " ";
-                }
-                break;
-            }
-            default:
-            {
-                cout << "Incompatible gate type: " << gate << "\n";
-                break;
+    for (int g = 0; g < (int)circuit.size(); g++){ //separate circuit into layers, record layer dividers in layers[], compile each layer's gates
+        const gateOp &op = circuit[g];
+        int touched = op.targetMask | op.controlMask;
+        if (reached & touched){
+            if (depth + 2 >= MAX_LAYERS){
+                cout << "Circuit has more than " << MAX_LAYERS - 2 << " layers\n\n";
+                return;
             }
+            compiledLayers.push_back(compileLayer(layerOps));
+            depth++;
+            layers[depth] = g;
+            reached = 0;
+            layerOps.clear();
         }
-        in >> ctrl >> gate;
-        gCount++;
+        reached |= touched;
+        layerOps.push_back(op);
     }
-    layerGates[depth] = gateBuffer;
+    compiledLayers.push_back(compileLayer(layerOps));
     depth++;
-    layers[depth] = gCount;
+    layers[depth] = (int)circuit.size();
     cout << "Divided into " << depth << " layers\n";
     
     complex<double> result = savitchRecur(N, 0, depth - 1, startState, endState, layers, verbose); //call recursive algorithm
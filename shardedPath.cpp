@@ -0,0 +1,179 @@
+//
+//  shardedPath.cpp
+//  PocketSimulator
+//
+//  Created on 10/16/26.
+//  Copyright © 2017. All rights reserved.
+//
+#include <iostream>
+#include <complex>
+#include <fstream>
+#include <time.h>
+#include <sys/time.h>
+#include <sys/resource.h>
+#include <math.h>
+#include <stdio.h>
+#define _USE_MATH_DEFINES
+
+#include "shardedPath.hpp"
+#include "pathIntegral.hpp"
+#include "circuit.hpp"
+#include "helpers.hpp"
+using namespace std;
+
+//SHARDING VARIABLES
+#define SHARD_EXTRA_LEVELS 10 //prefix levels beyond log2(# of shards): ~1024 prefixes per shard between checkpoints
+#define MAX_SHARD_LEVELS 40
+extern int N;
+extern int startState, endState;
+extern thread_local int currState;
+extern thread_local vector<complex<double>> amplitudes;
+extern vector<gateOp> circuit;
+extern vector<int> lightCone;
+
+//------------------------------SHARDED PATH INTEGRAL SUMMING------------------------------
+
+/* For runs that take days, the path tree is addressed by prefix index (see prefixTask): the first L Hadamard choices of a path, read as an
+ L-bit number. The 2^L prefixes are split into k contiguous ranges, and shard i (run as its own process, possibly on another machine)
+ sums the subtrees below the prefixes of range i with complexPathStep. L = log2(k) + 10 (at most the # of Hadamards), so every shard and
+ the reducer agree on it from the circuit alone.
+ 
+ A shard file records the run it belongs to (qubits, states, gate count and a hash of the compiled gates, shard i/k, L), the next unfinished prefix and the partial amplitude
+ so far. It is rewritten (atomically: written to a temporary file and renamed) every checkpointSeconds and when the shard finishes, so a
+ restarted shard resumes from its last checkpoint. The reducer sums finished shard files into the final amplitude. */
+
+struct shardState {
+    int qubits, start, end, gates;
+    unsigned long long circuitHash; //circuitHash of the gates, so an edited gate file of the same length is not taken for the same run
+    int shard, shards, levels;
+    long long next;
+    complex<double> amplitude;
+};
+
+/* circuitHash: 64-bit FNV-1a hash of every compiled gate (type, qubits and phase) */
+unsigned long long circuitHash(const vector<gateOp> &gates){
+    unsigned long long hash = 14695981039346656037ULL;
+    for (const gateOp &op : gates){
+        int fields[6] = {op.gate, op.target, op.c1, op.c2, op.phasePow, op.phaseSign};
+        for (int field : fields) for (int b = 0; b < 4; b++) hash = (hash ^ ((field >> (8 * b)) & 0xFF)) * 1099511628211ULL;
+    }
+    return hash;
+}
+
+long long shardBegin(const shardState &s){ return ((1LL << s.levels) * s.shard) / s.shards; }
+long long shardEnd(const shardState &s){ return ((1LL << s.levels) * (s.shard + 1)) / s.shards; }
+
+void writeShardFile(string path, const shardState &s){
+    string tempPath = path + ".tmp";
+    ofstream out(tempPath);
+    out.precision(17);
+    out << "PocketSimulator shard\n";
+    out << "qubits " << s.qubits << "\nstart " << s.start << "\nend " << s.end << "\ngates " << s.gates << "\ncircuit " << s.circuitHash << "\n";
+    out << "shard " << s.shard << " " << s.shards << "\nlevels " << s.levels << "\n";
+    out << "next " << s.next << "\namplitude " << s.amplitude.real() << " " << s.amplitude.imag() << "\n";
+    out.close();
+    if (!out || rename(tempPath.c_str(), path.c_str()) != 0) cout << "Could not write shard file " << path << "\n";
+}
+
+bool readShardFile(string path, shardState &s){
+    ifstream in(path);
+    string title, key;
+    double re, im;
+    getline(in, title);
+    if (title != "PocketSimulator shard") return false;
+    in >> key >> s.qubits >> key >> s.start >> key >> s.end >> key >> s.gates >> key >> s.circuitHash;
+    in >> key >> s.shard >> s.shards >> key >> s.levels >> key >> s.next >> key >> re >> im;
+    s.amplitude = complex<double>(re, im);
+    return !in.fail() && s.shards > 0 && s.levels >= 0 && s.levels <= MAX_SHARD_LEVELS; //the file is not trusted: shards and levels size arrays and shifts
+}
+
+void shardedPathIntegral(string gatePath, int n, int startS, int endS, int shard, int shards, string outPath, int checkpointSeconds, bool showRuntime){
+    cout << "Main Method: [PocketSimulator, shard " << shard << "/" << shards << "]\n" << n << " qubit simulation in progress........\n";
+    currState = startS, startState = startS, endState = endS;
+    N = n;
+    circuit = compileCircuit(gatePath, N);
+    lightCone = lightConeMasks(circuit);
+    int hadamards = hadamardCount(circuit), changingGates = 0;
+    amplitudes.assign(hadamards + 1, 0);
+    for (const gateOp &op : circuit) if (op.gate != 'p') changingGates++;
+    
+    shardState s = {N, startS, endS, (int)circuit.size(), circuitHash(circuit), shard, shards, 0, 0, 0};
+    while ((1LL << s.levels) < shards) s.levels++;
+    s.levels = min(min(s.levels + SHARD_EXTRA_LEVELS, hadamards), MAX_SHARD_LEVELS);
+    s.next = shardBegin(s);
+    
+    shardState saved;
+    if (readShardFile(outPath, saved)){ //resume from the last checkpoint of this same shard
+        if (saved.qubits == s.qubits && saved.start == s.start && saved.end == s.end && saved.gates == s.gates && saved.circuitHash == s.circuitHash &&
+            saved.shard == s.shard && saved.shards == s.shards && saved.levels == s.levels){
+            s = saved;
+            cout << "Resuming at prefix " << s.next << " of [" << shardBegin(s) << ", " << shardEnd(s) << ")\n";
+        } else cout << "Ignoring " << outPath << ": it belongs to a different run\n";
+    }
+    
+    time_t lastCheckpoint = time(NULL);
+    pathTask task;
+    for (; s.next < shardEnd(s); s.next++){
+        if (prefixTask(s.next, s.levels, startS, changingGates, task)){
+            currState = task.state;
+            complexPathStep(task.pos, task.changesLeft, task.phase, 0);
+            s.amplitude += amplitudes[0];
+        }
+        if (time(NULL) - lastCheckpoint >= checkpointSeconds){
+            writeShardFile(outPath, {s.qubits, s.start, s.end, s.gates, s.circuitHash, s.shard, s.shards, s.levels, s.next + 1, s.amplitude});
+            lastCheckpoint = time(NULL);
+        }
+    }
+    writeShardFile(outPath, s);
+    cout << "Shard " << shard << "/" << shards << " partial amplitude = " << s.amplitude.real() << " + " << s.amplitude.imag() << "i (written to " << outPath << ")\n";
+    
+    if (showRuntime){ //Print time usage
+        cout.precision(7);
+        struct rusage usage;
+        getrusage(RUSAGE_SELF, &usage);
+        long totaluTime = (usage.ru_stime.tv_sec + usage.ru_utime.tv_sec) * 1000000 + usage.ru_stime.tv_usec + usage.ru_utime.tv_usec;
+        double totalTime = totaluTime/ (double) 1000000;
+        cout << "Runtime: " << totalTime << " seconds\n";
+    }
+    cout << "\n";
+}
+
+void reduceShards(vector<string> shardPaths){
+    cout << "Reducing " << shardPaths.size() << " shard files\n";
+    vector<bool> seen;
+    shardState first, s;
+    complex<double> result = 0;
+    for (int i = 0; i < (int)shardPaths.size(); i++){
+        if (!readShardFile(shardPaths[i], s)){
+            cout << "Could not read shard file " << shardPaths[i] << "\n";
+            return;
+        }
+        if (i == 0){
+            first = s;
+            seen.assign(s.shards, false);
+        }
+        if (s.qubits != first.qubits || s.start != first.start || s.end != first.end || s.gates != first.gates || s.circuitHash != first.circuitHash ||
+            s.shards != first.shards || s.levels != first.levels || s.shard < 0 || s.shard >= s.shards){
+            cout << shardPaths[i] << " belongs to a different run\n";
+            return;
+        }
+        if (s.next < shardEnd(s)){
+            cout << shardPaths[i] << " is unfinished (shard " << s.shard << " stopped at prefix " << s.next << " of " << shardEnd(s) << ")\n";
+            return;
+        }
+        if (seen[s.shard]){
+            cout << "Shard " << s.shard << " appears twice\n";
+            return;
+        }
+        seen[s.shard] = true;
+        result += s.amplitude;
+    }
+    for (int i = 0; i < (int)seen.size(); i++){
+        if (!seen[i]){
+            cout << "Missing shard " << i << "/" << first.shards << "\n";
+            return;
+        }
+    }
+    if (shardPaths.empty()) return;
+    cout << "<" << binString(first.end, first.qubits) << "|Circuit|" << binString(first.start, first.qubits) << "> = " << result.real() << " + " << result.imag() << "i\n\n";
+}
@@ -0,0 +1,24 @@
+//
+//  shardedPath.hpp
+//  PocketSimulator
+//
+//  Created on 10/16/26.
+//  Copyright © 2017. All rights reserved.
+//
+
+#ifndef shardedPath_hpp
+#define shardedPath_hpp
+
+#include <stdio.h>
+#include <string>
+#include <vector>
+using namespace std;
+
+/* shardedPathIntegral: runs shard 'shard' (0 to shards - 1) of the path tree, writing its partial amplitude to outPath and checkpointing
+ its progress there every checkpointSeconds; an unfinished outPath from an earlier run of the same shard is resumed */
+void shardedPathIntegral(string gatePath, int N, int startState, int endState, int shard, int shards, string outPath, int checkpointSeconds, bool showRuntime);
+
+/* reduceShards: checks that the shard files cover every shard of one run, and prints the summed amplitude */
+void reduceShards(vector<string> shardPaths);
+
+#endif /* shardedPath_hpp */
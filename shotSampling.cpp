@@ -0,0 +1,177 @@
+//
+//  shotSampling.cpp
+//  PocketSimulator
+//
+//  Created on 10/16/26.
+//  Copyright © 2017. All rights reserved.
+//
+#include <iostream>
+#include <fstream>
+#include <random>
+#include <algorithm>
+#include <sys/time.h>
+#include <stdint.h>
+
+#include "shotSampling.hpp"
+#include "stateVector.hpp"
+#include "workPool.hpp"
+#include "helpers.hpp"
+using namespace std;
+
+//SHOT SAMPLING VARIABLES
+#define SHOT_BATCH (1LL << 16) //shots per random stream: batch b is seeded with (seed, b), so the samples do not depend on the thread count
+#define GATHER_BITS 16 //index bits per gather table lookup
+
+//-------------------------------------SHOT SAMPLING-----------------------------------------
+
+/* Measuring qubits q_0 ... q_(m-1) gives outcome x (bit m - 1 - j of x = qubit q_j, so binString(x, m) lists them in order) with
+ probability p(x) = sum of |amplitude|^2 over the indices that agree with x on those qubits. p is summed in one parallel sweep over the
+ vector: a physical index maps to its key (the outcome bits of the measured qubits stored in the vector) by two table lookups (the
+ gather of its low and high GATHER_BITS bits), every thread sums into its own copy of p over the keys, and the copies are added up. When
+ every stored qubit is measured, p is just |amplitude|^2 (in physical order) and no copies are needed. Measured qubits that are still
+ classical (see stateVector.cpp) are the same in every shot: their bits are set in each outcome as its key is expanded. The cumulative
+ table of p is then built by a parallel prefix sum (slice totals, then slice offsets), so p needs no normalization: a shot draws u
+ uniformly in [0, total) and takes the first entry whose cumulative sum exceeds u, a binary search of O(m) steps. Shots are drawn in
+ parallel batches of SHOT_BATCH, each with its own seeded 64-bit Mersenne Twister, then sorted and counted into the histogram.
+
+ The histogram file is CSV (a header, then "outcome bits,count" per line) when its path ends in .csv; otherwise it is binary, all
+ little-endian: the 8 bytes "PSHOTS01", int32 m, int64 shots, int64 # of outcomes, m int32 qubit numbers, then per outcome (ascending)
+ a uint64 outcome and an int64 count. */
+
+/* prefixSums: replaces values by their running sums, in parallel */
+void prefixSums(vector<double> &values, workPool *pool){
+    long long n = (long long)values.size();
+    vector<double> totals(pool ? pool->size() : 1, 0);
+    forEachSlice(pool, [&](int part, int parts){
+        double sum = 0;
+        for (long long i = n * part / parts; i < n * (part + 1) / parts; i++) sum += values[i], values[i] = sum;
+        totals[part] = sum;
+    });
+    forEachSlice(pool, [&](int part, int parts){
+        double offset = 0;
+        for (int p = 0; p < part; p++) offset += totals[p];
+        for (long long i = n * part / parts; i < n * (part + 1) / parts; i++) values[i] += offset;
+    });
+}
+
+template <typename T>
+void sampleShots(const T *re, const T *im, int N, const vector<int> &layout, int classical, const shotSettings &settings, workPool *pool){
+    struct timeval start, built, drawn;
+    gettimeofday(&start, NULL);
+    vector<int> qubits = settings.qubits;
+    if (qubits.empty()) for (int q = 0; q < N; q++) qubits.push_back(q);
+    int m = (int)qubits.size(), active = 0;
+    for (int bit : layout) if (bit >= 0) active++;
+    vector<int> keyBit(active, -1), outcomeBits; //keyBit[p] = the key bit stored at physical bit p, or -1; key bit k is outcome bit outcomeBits[k]
+    vector<bool> measured(N, false);
+    long long fixed = 0; //outcome bits of the measured classical qubits
+    for (int j = 0; j < m; j++){
+        if (qubits[j] < 0 || qubits[j] >= N || measured[qubits[j]]){
+            cout << "Measured qubits must be distinct and between 0 and " << N - 1 << "\n";
+            return;
+        }
+        measured[qubits[j]] = true;
+        int b = N - qubits[j] - 1;
+        if (layout[b] < 0) fixed |= (long long)((classical >> b) & 1) << (m - 1 - j);
+        else keyBit[layout[b]] = (int)outcomeBits.size(), outcomeBits.push_back(m - 1 - j);
+    }
+    int k = (int)outcomeBits.size(), lowBits = min(active, GATHER_BITS);
+    vector<long long> lowGather(1LL << lowBits, 0), highGather(1LL << (active - lowBits), 0);
+    for (long long x = 0; x < (long long)lowGather.size(); x++) for (int p = 0; p < lowBits; p++) if (((x >> p) & 1) && keyBit[p] >= 0) lowGather[x] |= 1LL << keyBit[p];
+    for (long long x = 0; x < (long long)highGather.size(); x++) for (int p = lowBits; p < active; p++) if (((x >> (p - lowBits)) & 1) && keyBit[p] >= 0) highGather[x] |= 1LL << keyBit[p];
+    auto key = [&](long long i){ return lowGather[i & ((1LL << lowBits) - 1)] | highGather[i >> lowBits]; };
+    auto outcome = [&](long long x){ //the outcome of key x
+        long long bits = fixed;
+        for (int j = 0; j < k; j++) if ((x >> j) & 1) bits |= 1LL << outcomeBits[j];
+        return bits;
+    };
+
+    bool every = k == active; //the table is indexed by physical index
+    long long spaceSize = 1LL << active, entries = 1LL << k;
+    long long available = availableMemory(); //0 when unknown: no check
+    int parts = pool ? pool->size() : 1;
+    long long tableBytes = (every ? 1 : parts + 1) * entries * (long long)sizeof(double) + settings.shots * (long long)sizeof(long long);
+    if (available > 0 && tableBytes > available){
+        cout << "Sampling needs " << tableBytes / 1048576.0 << " MB, but only " << available / 1048576.0 << " MB of memory is available\n";
+        return;
+    }
+    vector<double> cumulative(entries, 0);
+    if (every){
+        forEachSlice(pool, [&](int part, int parts){
+            for (long long i = spaceSize * part / parts; i < spaceSize * (part + 1) / parts; i++) cumulative[i] = (double)re[i] * re[i] + (double)im[i] * im[i];
+        });
+    } else {
+        vector<vector<double>> partial(parts);
+        forEachSlice(pool, [&](int part, int parts){
+            partial[part].assign(entries, 0);
+            for (long long i = spaceSize * part / parts; i < spaceSize * (part + 1) / parts; i++) partial[part][key(i)] += (double)re[i] * re[i] + (double)im[i] * im[i];
+        });
+        forEachSlice(pool, [&](int part, int parts){
+            for (long long x = entries * part / parts; x < entries * (part + 1) / parts; x++) for (int p = 0; p < (int)partial.size(); p++) cumulative[x] += partial[p][x];
+        });
+    }
+    prefixSums(cumulative, pool);
+    double total = cumulative.back();
+    gettimeofday(&built, NULL);
+    if (total <= 0){
+        cout << "Cannot sample shots from a zero vector\n";
+        return;
+    }
+
+    vector<long long> samples(settings.shots);
+    long long batches = (settings.shots + SHOT_BATCH - 1) / SHOT_BATCH;
+    forEachSlice(pool, [&](int part, int parts){
+        for (long long b = batches * part / parts; b < batches * (part + 1) / parts; b++){
+            seed_seq seeds = {(unsigned)settings.seed, (unsigned)(settings.seed >> 32), (unsigned)b, (unsigned)(b >> 32)};
+            mt19937_64 random(seeds);
+            for (long long s = b * SHOT_BATCH; s < min(settings.shots, (b + 1) * SHOT_BATCH); s++){
+                double u = (random() >> 11) * 0x1.0p-53 * total;
+                long long x = upper_bound(cumulative.begin(), cumulative.end(), u) - cumulative.begin();
+                x = min(x, entries - 1);
+                samples[s] = outcome(every ? key(x) : x);
+            }
+        }
+    });
+    sort(samples.begin(), samples.end());
+    vector<pair<long long, long long>> histogram; //(outcome, count), ascending
+    for (long long s = 0; s < settings.shots; s++){
+        if (histogram.empty() || histogram.back().first != samples[s]) histogram.push_back(make_pair(samples[s], 0LL));
+        histogram.back().second++;
+    }
+    gettimeofday(&drawn, NULL);
+
+    bool csv = settings.path.size() >= 4 && settings.path.compare(settings.path.size() - 4, 4, ".csv") == 0;
+    ofstream out(settings.path, csv ? ios::out : ios::out | ios::binary);
+    if (csv){
+        out << "outcome,count\n";
+        for (const pair<long long, long long> &h : histogram) out << binString((int)h.first, m) << "," << h.second << "\n";
+    } else {
+        int32_t width = m;
+        int64_t shots = settings.shots, outcomes = (int64_t)histogram.size();
+        out.write("PSHOTS01", 8);
+        out.write((const char *)&width, sizeof(width));
+        out.write((const char *)&shots, sizeof(shots));
+        out.write((const char *)&outcomes, sizeof(outcomes));
+        for (int q : qubits){
+            int32_t qubit = q;
+            out.write((const char *)&qubit, sizeof(qubit));
+        }
+        for (const pair<long long, long long> &h : histogram){
+            uint64_t x = h.first;
+            int64_t count = h.second;
+            out.write((const char *)&x, sizeof(x));
+            out.write((const char *)&count, sizeof(count));
+        }
+    }
+    if (!out){
+        cout << "Could not write the histogram to " << settings.path << "\n";
+        return;
+    }
+    double buildSeconds = (built.tv_sec - start.tv_sec) + (built.tv_usec - start.tv_usec) / (double) 1000000;
+    double drawSeconds = (drawn.tv_sec - built.tv_sec) + (drawn.tv_usec - built.tv_usec) / (double) 1000000;
+    cout << "Shots: " << settings.shots << " samples of " << m << " qubits, " << histogram.size() << " distinct outcomes, written to " << settings.path
+         << " (table " << buildSeconds << " seconds, draws " << drawSeconds << " seconds)\n";
+}
+
+template void sampleShots<double>(const double *re, const double *im, int N, const vector<int> &layout, int classical, const shotSettings &settings, workPool *pool);
+template void sampleShots<float>(const float *re, const float *im, int N, const vector<int> &layout, int classical, const shotSettings &settings, workPool *pool);
@@ -0,0 +1,33 @@
+//
+//  shotSampling.hpp
+//  PocketSimulator
+//
+//  Created on 10/16/26.
+//  Copyright © 2017. All rights reserved.
+//
+
+#ifndef shotSampling_hpp
+#define shotSampling_hpp
+
+#include <stdio.h>
+#include <string>
+#include <vector>
+using namespace std;
+
+class workPool;
+
+/* shotSettings: measurements to sample from a final state vector */
+struct shotSettings {
+    long long shots; //# of measurement samples (0 = none)
+    vector<int> qubits; //measured qubits, in outcome order (empty = every qubit, 0 to N - 1)
+    unsigned long long seed; //the same seed gives the same samples, whatever the thread count
+    string path; //histogram file: CSV (outcome bits,count) if it ends in .csv, binary otherwise (see shotSampling.cpp)
+};
+
+/* sampleShots: draws settings.shots measurements of settings.qubits from the amplitudes of an N-qubit state at re, im (stored with index
+ bit b at bit layout[b], or fixed to bit b of classical when layout[b] < 0, and normalized or not) and writes their histogram to
+ settings.path */
+template <typename T>
+void sampleShots(const T *re, const T *im, int N, const vector<int> &layout, int classical, const shotSettings &settings, workPool *pool);
+
+#endif /* shotSampling_hpp */
@@ -0,0 +1,163 @@
+//
+//  sparseVector.cpp
+//  PocketSimulator
+//
+//  Created on 10/16/26.
+//  Copyright © 2017. All rights reserved.
+//
+#include <iostream>
+#include <complex>
+#include <vector>
+#include <memory>
+#include <math.h>
+#include <sys/time.h>
+#include <sys/resource.h>
+#define _USE_MATH_DEFINES
+
+#include "sparseVector.hpp"
+#include "stateVector.hpp"
+#include "gateFusion.hpp"
+#include "cacheBlocking.hpp"
+#include "workPool.hpp"
+#include "circuit.hpp"
+#include "helpers.hpp"
+using namespace std;
+
+//SPARSE STATE VECTOR VARIABLES
+#define EMPTY_STATE -1
+#define MIN_TABLE_SLOTS 16
+
+//--------------------------------SPARSE STATE VECTOR---------------------------------------
+
+/* Toffoli-heavy circuits, or a Draper adder started from a basis state, keep few nonzero amplitudes: a Toffoli or phase gate never adds
+ any, and a Hadamard at most doubles them. The sparse engine keeps only the nonzero amplitudes, in an open-addressing hash table (linear
+ probing, Fibonacci hashing of the state, at most half full), so a gate costs time in the size of the support rather than 2^N.
+
+ A phase gate scales the matching entries in place. A Hadamard or Toffoli moves amplitudes to other states, so it builds the next table
+ from the current one (sized for the most entries it can produce) and the two are swapped; amplitudes of magnitude at most pruneCutoff
+ (cancelled pairs, mostly) are dropped while copying, and their squared norm is reported as the error bound. When more than
+ denseFraction of all states are nonzero, the hash table costs more than the dense vector: the amplitudes are scattered into a dense
+ vector and the rest of the circuit is fused and run as by stateVector. */
+
+struct sparseEntry {
+    int state;
+    double re, im;
+};
+
+class sparseTable {
+public:
+    vector<sparseEntry> slots;
+    long long count;
+
+    void reset(long long entries){ //empty, with room for 'entries' states at most half full
+        long long capacity = MIN_TABLE_SLOTS;
+        while (capacity < 2 * entries) capacity *= 2;
+        slots.assign(capacity, {EMPTY_STATE, 0, 0});
+        mask = capacity - 1, shift = 64 - __builtin_ctzll(capacity), count = 0;
+    }
+
+    sparseEntry *find(int state){ //the state's entry, or NULL
+        for (long long i = slot(state); ; i = (i + 1) & mask){
+            if (slots[i].state == state) return &slots[i];
+            if (slots[i].state == EMPTY_STATE) return NULL;
+        }
+    }
+
+    void add(int state, double re, double im){ //adds to the state's amplitude (the table must have room)
+        long long i = slot(state);
+        while (slots[i].state != state && slots[i].state != EMPTY_STATE) i = (i + 1) & mask;
+        if (slots[i].state == EMPTY_STATE) slots[i].state = state, count++;
+        slots[i].re += re, slots[i].im += im;
+    }
+
+private:
+    long long mask;
+    int shift;
+    long long slot(int state){ return (long long)(((unsigned long long)(unsigned int)state * 0x9E3779B97F4A7C15ULL) >> shift) & mask; }
+};
+
+void sparseStateVector(string gatePath, int N, int startState, int endState, double pruneCutoff, double denseFraction, int fusionQubits, bool cacheBlocking,
+                       int numThreads, bool showRuntime){
+    cout << "Comparison algorithm: [sparse stateVector]\n" << N << " qubit simulation in progress........\n";
+    struct timeval wallStart, wallEnd;
+    gettimeofday(&wallStart, NULL);
+    vector<gateOp> circuit = compileCircuit(gatePath, N);
+    long long spaceSize = 1LL << N, peak = 1, denseAt = (long long)(denseFraction * spaceSize);
+    double pruned = 0, cutoff = pruneCutoff * pruneCutoff;
+    sparseTable current, next;
+    current.reset(1);
+    current.add(startState, 1, 0);
+
+    int g = 0;
+    for (; g < (int)circuit.size() && current.count <= denseAt; g++){
+        const gateOp &op = circuit[g];
+        if (op.gate == 'p'){
+            double c = op.phase.real(), s = op.phase.imag();
+            for (sparseEntry &e : current.slots){
+                if (e.state == EMPTY_STATE || (e.state & op.controlMask) != op.controlMask) continue;
+                double re = e.re;
+                e.re = re * c - e.im * s, e.im = re * s + e.im * c;
+            }
+            continue;
+        }
+        next.reset(op.gate == 'h' ? 2 * current.count : current.count);
+        for (const sparseEntry &e : current.slots){
+            if (e.state == EMPTY_STATE) continue;
+            if (e.re * e.re + e.im * e.im <= cutoff){
+                pruned += e.re * e.re + e.im * e.im;
+                continue;
+            }
+            if (op.gate == 't'){
+                next.add((e.state & op.controlMask) == op.controlMask ? e.state ^ op.targetMask : e.state, e.re, e.im);
+                continue;
+            }
+            double sign = (e.state & op.targetMask) ? -M_SQRT1_2 : M_SQRT1_2; //|1> --> (|0> - |1>)/sqrt(2)
+            next.add(e.state & ~op.targetMask, M_SQRT1_2 * e.re, M_SQRT1_2 * e.im);
+            next.add(e.state | op.targetMask, sign * e.re, sign * e.im);
+        }
+        swap(current, next);
+        peak = max(peak, current.count);
+    }
+
+    complex<double> amplitude = 0;
+    long long sweeps = 0;
+    if (g < (int)circuit.size()){ //the support outgrew denseFraction: the rest runs on the dense vector
+        cout << "Switching to the dense state vector at gate " << g << " of " << circuit.size() << " (" << current.count << " nonzero amplitudes)\n";
+        unique_ptr<workPool> pool;
+        if (numThreads != 1){
+            pool.reset(new workPool(numThreads));
+            pool->pin();
+        }
+        double *ampRe = allocAmplitudes<double>(spaceSize, false, pool.get());
+        if (ampRe == NULL){
+            cout << "\n";
+            return;
+        }
+        double *ampIm = ampRe + spaceSize;
+        for (const sparseEntry &e : current.slots) if (e.state != EMPTY_STATE) ampRe[e.state] = e.re, ampIm[e.state] = e.im;
+        current = sparseTable(), next = sparseTable(); //the tables' memory is freed before the dense run
+        vector<gateOp> rest(circuit.begin() + g, circuit.end());
+        vector<int> layout;
+        evolveVector(fuseGates(rest, N, fusionQubits), ampRe, ampIm, N, false, cacheBlocking, pool.get(), layout, sweeps);
+        long long end = physicalIndex(endState, layout);
+        amplitude = complex<double>(ampRe[end], ampIm[end]);
+        free(ampRe);
+    } else {
+        sparseEntry *end = current.find(endState);
+        if (end != NULL) amplitude = complex<double>(end->re, end->im);
+    }
+    cout << "<" << binString(endState, N) << "|Circuit|" << binString(startState, N) << "> = " << amplitude.real() << " + " << amplitude.imag() << "i\n";
+
+    if (showRuntime){ //Print time usage (CPU time summed over all threads, and wall-clock time)
+        cout.precision(7);
+        struct rusage usage;
+        getrusage(RUSAGE_SELF, &usage);
+        gettimeofday(&wallEnd, NULL);
+        long totaluTime = (usage.ru_stime.tv_sec + usage.ru_utime.tv_sec) * 1000000 + usage.ru_stime.tv_usec + usage.ru_utime.tv_usec;
+        long wall = (wallEnd.tv_sec - wallStart.tv_sec) * 1000000 + wallEnd.tv_usec - wallStart.tv_usec;
+        cout << "Runtime: " << totaluTime / (double) 1000000 << " seconds (" << g << " gates sparse, at most " << peak << " nonzero amplitudes, pruned norm " << pruned;
+        if (g < (int)circuit.size()) cout << "; " << circuit.size() - g << " gates dense in " << sweeps << " sweeps";
+        cout << ", wall clock " << wall / (double) 1000000 << " seconds)\n";
+    }
+    cout << "\n";
+}
@@ -0,0 +1,22 @@
+//
+//  sparseVector.hpp
+//  PocketSimulator
+//
+//  Created on 10/16/26.
+//  Copyright © 2017. All rights reserved.
+//
+
+#ifndef sparseVector_hpp
+#define sparseVector_hpp
+
+#include <stdio.h>
+#include <string>
+using namespace std;
+
+/* sparseStateVector: the state vector algorithm on only the nonzero amplitudes, kept in a hash table keyed by basis state. Amplitudes of
+ magnitude at most pruneCutoff are dropped. Once more than denseFraction of the 2^N states are nonzero, the rest of the circuit runs on
+ the dense state vector (with fusionQubits, cacheBlocking and numThreads as for stateVector). */
+void sparseStateVector(string gatePath, int N, int startState, int endState, double pruneCutoff, double denseFraction, int fusionQubits, bool cacheBlocking,
+                       int numThreads, bool showRuntime);
+
+#endif /* sparseVector_hpp */
@@ -12,178 +12,437 @@
 #include <sys/time.h>
 #include <sys/resource.h>
 #include <math.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <sys/mman.h>
 #define _USE_MATH_DEFINES
 
 #include "helpers.hpp"
 #include "stateVector.hpp"
+#include "gateKernels.hpp"
+#include "workPool.hpp"
+#include "circuit.hpp"
+#include "gateFusion.hpp"
+#include "cacheBlocking.hpp"
+#include "shotSampling.hpp"
 
 using namespace std;
 //STATE VECTOR VARIABLES
 #define MAX_LAYERS 1000
-complex<double> amps[INT_MAX/2048]; //used for amplitude storage
+#define AMP_ALIGNMENT 64 //cache line (and AVX-512 vector) alignment of the amplitude array
+#define HUGE_PAGE_BYTES (2LL << 20)
+#define PARALLEL_MIN_QUBITS 16 //smaller vectors are simulated on one thread: a gate takes less time than waking the pool
 
-//---------------------------------STATE VECTOR EVOLUTION----------------------------------
+//---------------------------------AMPLITUDE ALLOCATION------------------------------------
 
-/* First simulation algorithm: tracking entire state vector
- Takes time T*exp(O(n)) and space exp(O(n)) [T = total # of gates]
- 
- PARAMETERS:
- in: file input stream to read gates from
- n: number of qubits
- startState: starting state of qubit register
- verbose: set to true to print intermediate amplitude values between each gate,
- false to only print the end amplitudes
- 
- MODIFIED VERBOSE: TRUE = PRINT ALL END AMPLITUDES, FALSE = ONLY PRINTS "DONE"
- (because of very large state spaces yielding massive console outputs, verbose was adjusted from the previous definition.) */
+/* allocAmplitudes: a zeroed, split array of count amplitudes of type T (count real parts followed by count imaginary parts), aligned to a cache line,
+ or to a 2 MB huge page (with transparent huge pages requested from the kernel) when hugePages is set and the array spans at least one.
+ Before allocating, the size is compared with the memory that is currently available (where the OS reports it), since running a 2^N array into swap
+ is far slower than failing. Returns NULL (with the reason printed) if the array does not fit; free the result with free().
+ With a pool, each worker zeroes (and so first touches, placing the pages on its own NUMA node) the slice of the array its gates use. */
+template <typename T>
+T *allocAmplitudes(long long count, bool hugePages, workPool *pool){
+    long long bytes = 2 * count * (long long)sizeof(T);
+    long long available = availableMemory(); //0 when unknown: no check
+    if (count <= 0 || bytes / (2 * (long long)sizeof(T)) != count || (available > 0 && bytes > available)){
+        cout << "State vector of " << count << " amplitudes needs " << bytes / 1048576.0 << " MB, but only " << available / 1048576.0 << " MB of memory is available\n";
+        return NULL;
+    }
+    bool huge = hugePages && bytes >= HUGE_PAGE_BYTES;
+    long long alignment = huge ? HUGE_PAGE_BYTES : AMP_ALIGNMENT;
+    bytes = (bytes + alignment - 1) / alignment * alignment;
+    void *memory = NULL;
+    if (posix_memalign(&memory, alignment, bytes) != 0){
+        cout << "Could not allocate " << bytes / 1048576.0 << " MB for the state vector\n";
+        return NULL;
+    }
+#ifdef MADV_HUGEPAGE
+    if (huge) madvise(memory, bytes, MADV_HUGEPAGE); //only a hint: without transparent huge pages the array uses normal pages
+#endif
+    T *array = (T *)memory;
+    forEachSlice(pool, [array, count](int part, int parts){
+        for (long long i = count * part / parts; i < count * (part + 1) / parts; i++) array[i] = array[count + i] = 0;
+    });
+    return array;
+}
 
-void stateVector(string gatePath, int N, int startState, int endState, bool verbose, bool showRuntime){
-    cout << "Comparison algorithm: [stateVector]\n" << N << " qubit simulation in progress........\n";
-    ifstream in = ifstream(gatePath);
-    int spaceSize = (int)pow(2,N);
-    
-    for (int i = 0; i < spaceSize; i++){ //initialize amps array
-        amps[i] = 0;
+template double *allocAmplitudes<double>(long long count, bool hugePages, workPool *pool);
+template float *allocAmplitudes<float>(long long count, bool hugePages, workPool *pool);
+
+/* forEachSlice: runs slice(part, parts) for every part, each on its own (pinned) worker of the pool, or as a single part without one */
+void forEachSlice(workPool *pool, function<void(int, int)> slice){
+    if (pool == NULL){
+        slice(0, 1);
+        return;
     }
-    amps[startState] = 1; //amplitude of the starting state is one
-    in.clear();
-    in.seekg(0, ios::beg); //go to beginning of file
-    
-    char gate;
-    int control, c1, c2, target, ctrl;
-    int index, toff;
-    int Hplus, H, zeroI, oneI;
-    double temp;
-    complex<double> ctemp;
-    complex<double> phase;
-    int phasePow;
-    
-    in >> control >> gate;
-    while (!in.eof()){
-        switch (gate) {
-            case 'h': //hadamard gate
-            {
-                if (verbose) cout << "hadamard detected\n";
-                in >> target;
-                complex<double> zero, one;
-                Hplus = pow(2, N - target), H = Hplus/2;
-                
-                //iterate over state vectors where target qubit == 0, updating both vectors (where the target = 0 and = 1) together
-                for (int i = 0; i < spaceSize; i += Hplus){
-                    for (int j = 0; j < H; j++){
-                        zeroI = i + j;
-                        oneI = zeroI | (1 << (N - target - 1));
-                        zero = 1/sqrt(2) * amps[zeroI];
-                        one = 1/sqrt(2) * amps[oneI];
-                        amps[zeroI] = zero + one;
-                        amps[oneI] = zero - one;
-                    }
-                }
-                break;
-            }
-            case 't':
-            {
-                if (verbose) cout << "toffoli detected\n";
-                in >> c1 >> c2 >> target;
-                if (c1 > c2){
-                    temp = c1;
-                    c1 = c2;
-                    c2 = temp;
-                }
-                
-                /* Iterate over state vectors where both control qubits are 1. The previous approach looped over all states, but this one saves time by factor of 4 by only iterating over those where toffoli actually does something. */
-                int inci = pow(2, N - c1), incj = pow(2, N - c2), C1 = inci/2, C2 = incj/2;
-                for (int i = 0; i < spaceSize; i += inci){ //increments qubits before c1
-                    for (int j = 0; j < C1; j += incj){ //increments qubits between c1 and c2
-                        for (int k = 0; k < C2; k++){ //increments qubits after c2
-                            index = k + C1 + j + C2 + i; //index where c1, c2 == 1
-                            if (((index >> (N - target - 1)) & 1) == 0){
-                                toff = index ^ (1 << (N - target - 1));
-                                ctemp = amps[toff];
-                                amps[toff] = amps[index];
-                                amps[index] = ctemp;
-                            }
-                        }
-                    }
-                }
-                break;
+    int parts = pool->size();
+    for (int p = 0; p < parts; p++) pool->submitTo(p, [&slice, p, parts](int){ slice(p, parts); });
+    pool->wait();
+}
+
+//---------------------------------STATE VECTOR EVOLUTION----------------------------------
+
+/* applyPass: applies slice 'part' of 'parts' of a pass to the size amplitudes at re, im: the block of the vector starting at index base.
+ The pass mixes only bits inside the block; control and phase bits above it are the same for the whole block, which they either select
+ entirely or not at all. */
+template <typename T>
+void applyPass(const basicGateKernels<T> &kernels, const fusedGate &pass, T *re, T *im, long long size, long long base, int N, int part, int parts){
+    long long inside = size - 1;
+    switch (pass.kind){
+        case 'g': //a single gate
+        {
+            const gateOp &op = pass.op;
+            int bit = N - op.target - 1;
+            long long controls = op.controlMask;
+            if ((base & controls) != (controls & ~inside)) return; //a control above the block is 0 here
+            switch (op.gate){
+                case 'h': kernels.hadamard(re, im, size, bit, part, parts); break;
+                /* Only the states where both control qubits are 1 (and the target is 0) are visited, swapping each with its target = 1 partner. */
+                case 't': kernels.toffoli(re, im, size, controls & inside, bit, part, parts); break;
+                case 'p': kernels.phase(re, im, size, controls & inside, op.phase.real(), op.phase.imag(), part, parts); break; //U/u: the phase applies where both the control (if any) and the target are 1
+                default: break;
             }
-            case 'U':
-            {
-                in >> phasePow;
-                phase = polar(1.0, 1/pow(2, phasePow) * 2 * M_PI);
-                if (control){ // controlled gate case
-                    in >> ctrl >> target;
-                    if (target > ctrl){
-                        temp = ctrl;
-                        ctrl = target;
-                        target = temp;
-                    }
-                    int inci = pow(2, N - target), incj = pow(2, N - ctrl), C = inci/2, targBit = incj/2;
-                    for (int i = 0; i < spaceSize; i += inci){
-                        for (int j = 0; j < C; j += incj){
-                            for (int k = 0; k < targBit; k++) amps[i + C + j + targBit + k] *= phase;
-                        }
-                    }
-                } else { // non-controlled gate case
-                    in >> target;
-                    int inc = pow(2, N - target), targBit = inc/2;
-                    for (int i = 0; i < spaceSize; i += inc){
-                        for (int j = 0; j < targBit; j++) amps[i + targBit + j] *= phase;
-                    }
-                }
+            break;
+        }
+        case 'u': //fused gates: one sweep for the whole group
+            kernels.fused(re, im, size, pass.bits.data(), (int)pass.bits.size(), pass.re.data(), pass.im.data(), false, part, parts);
+            break;
+        case 'd': //a diagonal: its bits above the block only pick which of its entries apply here
+        {
+            int k = 0, fixed = 0, width = (int)pass.bits.size();
+            while (k < width && pass.bits[k] < 63 && (1LL << pass.bits[k]) <= inside) k++;
+            if (k == width){
+                kernels.fused(re, im, size, pass.bits.data(), k, pass.re.data(), pass.im.data(), true, part, parts);
                 break;
             }
-            case 'u':
-            {
-                in >> phasePow;
-                phase = polar(1.0, -1/pow(2, phasePow) * 2 * M_PI);
-                if (control){ // controlled gate case
-                    in >> ctrl >> target;
-                    if (target > ctrl){
-                        temp = ctrl;
-                        ctrl = target;
-                        target = temp;
-                    }
-                    int inci = pow(2, N - target), incj = pow(2, N - ctrl), C = inci/2, targBit = incj/2;
-                    for (int i = 0; i < spaceSize; i += inci){
-                        for (int j = 0; j < C; j += incj){
-                            for (int k = 0; k < targBit; k++) amps[i + C + j + targBit + k] *= phase;
-                        }
-                    }
-                } else { // non-controlled gate case
-                    in >> target;
-                    int inc = pow(2, N - target), targBit = inc/2;
-                    for (int i = 0; i < spaceSize; i += inc){
-                        for (int j = 0; j < targBit; j++) amps[i + targBit + j] *= phase;
-                    }
-                }
-                break;
+            for (int b = k; b < width; b++) if ((base >> pass.bits[b]) & 1) fixed |= 1 << b;
+            double dRe[1 << MAX_FUSED_QUBITS], dIm[1 << MAX_FUSED_QUBITS];
+            for (int j = 0; j < (1 << k); j++) dRe[j] = pass.re[fixed | j], dIm[j] = pass.im[fixed | j];
+            if (k == 0) kernels.phase(re, im, size, 0, dRe[0], dIm[0], part, parts);
+            else kernels.fused(re, im, size, pass.bits.data(), k, dRe, dIm, true, part, parts);
+            break;
+        }
+        case 'z': //a run of phase gates
+            kernels.phaseTable(re, im, size, base, pass.bits.data(), (int)pass.bits.size(), pass.re.data(), pass.im.data(), part, parts);
+            break;
+        default: break;
+    }
+}
+
+template void applyPass<double>(const gateKernels &kernels, const fusedGate &pass, double *re, double *im, long long size, long long base, int N, int part, int parts);
+template void applyPass<float>(const basicGateKernels<float> &kernels, const fusedGate &pass, float *re, float *im, long long size, long long base, int N, int part, int parts);
+
+void printPass(const fusedGate &pass){
+    if (pass.kind == 'g' && pass.op.gate == 'h') cout << "hadamard detected\n";
+    if (pass.kind == 'g' && pass.op.gate == 't') cout << "toffoli detected\n";
+    if (pass.kind == 'z') cout << "phase table over " << pass.bits.size() << " qubits (" << pass.gates << " gates)\n";
+    if (pass.kind == 'u' || pass.kind == 'd') cout << "fused " << pass.bits.size() << "-qubit " << (pass.kind == 'd' ? "diagonal" : "unitary") << " (" << pass.gates << " gates)\n";
+}
+
+/* evolveVector: applies the passes to the 2^N amplitudes at re, im (stored with index bit b at bit b), in sweeps as described below; the
+ result is stored with index bit b at bit layout[b] */
+template <typename T>
+void evolveVector(const vector<fusedGate> &passes, T *ampRe, T *ampIm, int N, bool verbose, bool cacheBlocking, workPool *pool, vector<int> &layout, long long &sweeps){
+    long long spaceSize = 1LL << N;
+    const basicGateKernels<T> &kernels = selectKernels<T>(spaceSize);
+    int blockQubits = cacheBlocking ? blockQubitsFor(N, pool ? pool->size() : 1, sizeof(T)) : N;
+    vector<blockStep> steps = scheduleBlocks(passes, N, blockQubits, layout);
+    long long blockSize = 1LL << blockQubits, blocks = spaceSize >> blockQubits;
+    sweeps = 0;
+    
+    for (const blockStep &step : steps){
+        if (step.kind == 's'){ //swap a qubit into the block
+            if (verbose) cout << "swap bits " << step.low << " and " << step.high << "\n";
+            forEachSlice(pool, [&](int part, int parts){ swapBits(ampRe, ampIm, spaceSize, step.low, step.high, part, parts); });
+            sweeps++;
+            continue;
+        }
+        if (blocks == 1){ //unblocked: a sweep per pass, split across the threads
+            for (const fusedGate &pass : step.passes){
+                if (verbose) printPass(pass);
+                forEachSlice(pool, [&](int part, int parts){ applyPass(kernels, pass, ampRe, ampIm, spaceSize, 0, N, part, parts); });
+                sweeps++;
             }
-            default:
-            {
-                cout << "Incompatible gate type: " << gate << "\n";
-                break;
+            continue;
+        }
+        if (verbose) cout << "block sweep (" << step.passes.size() << " passes)\n";
+        forEachSlice(pool, [&](int part, int parts){ //each thread takes its own blocks, every pass at a time
+            for (long long b = blocks * part / parts; b < blocks * (part + 1) / parts; b++){
+                for (const fusedGate &pass : step.passes) applyPass(kernels, pass, ampRe + b * blockSize, ampIm + b * blockSize, blockSize, b * blockSize, N, 0, 1);
             }
+        });
+        sweeps++;
+    }
+}
+
+template void evolveVector<double>(const vector<fusedGate> &passes, double *ampRe, double *ampIm, int N, bool verbose, bool cacheBlocking, workPool *pool, vector<int> &layout, long long &sweeps);
+
+//---------------------------------LAZY QUBIT ACTIVATION-----------------------------------
+
+/* A qubit that no gate has put in superposition yet is a classical bit: it needs no dimension in the vector. The circuit is planned
+ once, gate by gate, on the classical bits: a Toffoli or phase gate with a classical control of 0 does nothing, a classical control of
+ 1 is dropped, a Toffoli on classical bits only flips its target bit, and a phase gate on classical bits only scales the whole state.
+ A qubit is activated (given the vector's next bit) when a gate must act on it in superposition: its first Hadamard, or a Toffoli
+ onto it with a control already active. Activating a qubit of value v doubles the vector, with the amplitudes so far in the half of
+ index bit v (the other half zero), so the vector holds only 2^A amplitudes for the A qubits activated so far, and the early layers
+ run on a much smaller vector; qubits that are never activated never cost memory at all. */
+
+/* lazyPlan: the circuit with its classical qubits resolved. Before the gates of segments[k] run, qubit activated[k] (of value values[k])
+ becomes bit k of the vector; the gates act on activated qubits only, numbered by activation order (their masks are left unset). */
+struct lazyPlan {
+    vector<int> activated, values;
+    vector<vector<gateOp>> segments;
+    int classical; //bits of the qubits never activated (bits of activated qubits are 0)
+    complex<double> phase; //global phase from the phase gates on classical qubits
+};
+
+/* planLazy: the plan of the circuit from basis state startState; without lazy, every qubit is activated before the first gate */
+lazyPlan planLazy(const vector<gateOp> &circuit, int N, int startState, bool lazy){
+    lazyPlan plan;
+    plan.classical = startState, plan.phase = 1;
+    vector<int> position(N, -1); //position[q] = activation order of qubit q, or -1 while it is classical
+    auto activate = [&](int q){
+        position[q] = (int)plan.activated.size();
+        plan.activated.push_back(q);
+        plan.values.push_back((plan.classical >> (N - q - 1)) & 1);
+        plan.classical &= ~(1 << (N - q - 1));
+        plan.segments.push_back(vector<gateOp>());
+    };
+    if (!lazy) for (int b = 0; b < N; b++) activate(N - b - 1); //index bit b is vector bit b, as without activation
+    
+    for (const gateOp &op : circuit){
+        bool skip = false;
+        int controls[2], count = 0; //active controls (for a phase gate, its active qubits)
+        int qubits[3] = {op.gate == 'p' ? op.target : op.c1, op.gate == 'p' ? op.c1 : op.c2, -1};
+        for (int j = 0; op.gate != 'h' && j < 2; j++){
+            int q = qubits[j];
+            if (q < 0) continue;
+            if (position[q] >= 0) controls[count++] = q;
+            else if (!((plan.classical >> (N - q - 1)) & 1)) skip = true; //a classical 0 control: the gate does nothing
+        }
+        if (skip) continue;
+        if (op.gate == 'p' && count == 0){
+            plan.phase *= op.phase;
+            continue;
+        }
+        if (op.gate == 't' && position[op.target] < 0 && count == 0){
+            plan.classical ^= op.targetMask;
+            continue;
         }
-        in >> control >> gate;
+        if (op.gate != 'p' && position[op.target] < 0) activate(op.target);
+        gateOp mapped = op;
+        if (op.gate == 'p') mapped.target = position[controls[0]], mapped.c1 = count > 1 ? position[controls[1]] : -1;
+        else {
+            mapped.target = position[op.target];
+            mapped.c1 = count > 0 ? position[controls[0]] : -1, mapped.c2 = count > 1 ? position[controls[1]] : -1;
+        }
+        plan.segments.back().push_back(mapped);
     }
-    if (verbose){
-        for (int i = 0; i < spaceSize; i++){
-            cout << binString(i, N) << ": " << amps[i] << "\n";
+    return plan;
+}
+
+/* storedIndex: where the amplitude of basis state 'logical' is kept (index bit b at bit layout[b]), or -1 if the state disagrees with
+ the classical bits (layout[b] < 0), so that its amplitude is 0 */
+long long storedIndex(long long logical, const vector<int> &layout, int classical){
+    long long physical = 0;
+    for (int b = 0; b < (int)layout.size(); b++){
+        if (layout[b] < 0){
+            if (((logical ^ classical) >> b) & 1) return -1;
+        } else if ((logical >> b) & 1) physical |= 1LL << layout[b];
+    }
+    return physical;
+}
+
+/* evolveLazy: runs the plan with amplitudes of type T. Returns the amplitude array (2^A real parts, then 2^A imaginary parts, for the A
+ activated qubits; index bit b is stored at bit layout[b], or is classical when layout[b] < 0) or NULL if it does not fit in memory. */
+template <typename T>
+T *evolveLazy(const lazyPlan &plan, int N, int fusionQubits, bool verbose, bool hugePages, bool cacheBlocking, workPool *pool,
+              vector<int> &layout, long long &passCount, long long &sweeps){
+    int active = (int)plan.activated.size();
+    long long spaceSize = 1LL << active, basis = 0; //until the first gate runs, the vector is the basis state 'basis'
+    T *ampRe = allocAmplitudes<T>(spaceSize, hugePages, pool); //zero-initialized amps array
+    if (ampRe == NULL) return NULL;
+    T *ampIm = ampRe + spaceSize;
+    vector<int> bits; //bits[k] = the bit of the array holding activated qubit k
+    bool started = false;
+    passCount = sweeps = 0;
+    for (int k = 0; k < active; k++){
+        long long size = 1LL << k;
+        if (!started) basis |= (long long)plan.values[k] << k;
+        else if (plan.values[k]){ //the qubit is 1: the amplitudes move to the upper half
+            forEachSlice(k >= PARALLEL_MIN_QUBITS ? pool : NULL, [&](int part, int parts){
+                for (long long i = size * part / parts; i < size * (part + 1) / parts; i++){
+                    ampRe[size + i] = ampRe[i], ampIm[size + i] = ampIm[i];
+                    ampRe[i] = ampIm[i] = 0;
+                }
+            });
+        }
+        bits.push_back(k);
+        if (plan.segments[k].empty()) continue;
+        if (!started) ampRe[basis] = 1, started = true;
+        int A = k + 1; //the gates run on an A-qubit register, where array bit p is qubit A - p - 1
+        vector<gateOp> gates;
+        for (const gateOp &op : plan.segments[k]){
+            gateOp mapped = op;
+            mapped.target = A - bits[op.target] - 1;
+            mapped.c1 = op.c1 >= 0 ? A - bits[op.c1] - 1 : -1, mapped.c2 = op.c2 >= 0 ? A - bits[op.c2] - 1 : -1;
+            mapped.targetMask = 1 << bits[op.target];
+            mapped.controlMask = (op.gate == 'p' ? mapped.targetMask : 0) | (op.c1 >= 0 ? 1 << bits[op.c1] : 0) | (op.c2 >= 0 ? 1 << bits[op.c2] : 0);
+            gates.push_back(mapped);
         }
+        vector<fusedGate> passes = fuseGates(gates, A, fusionQubits);
+        vector<int> segmentLayout;
+        long long segmentSweeps;
+        evolveVector(passes, ampRe, ampIm, A, verbose, cacheBlocking, A >= PARALLEL_MIN_QUBITS ? pool : NULL, segmentLayout, segmentSweeps);
+        for (int &bit : bits) bit = segmentLayout[bit];
+        passCount += passes.size(), sweeps += segmentSweeps;
+    }
+    if (!started) ampRe[basis] = 1;
+    layout.assign(N, -1);
+    for (int k = 0; k < active; k++) layout[N - plan.activated[k] - 1] = bits[k];
+    return ampRe;
+}
+
+//---------------------------------STATE VECTOR ALGORITHM----------------------------------
+
+/* squaredNorm: the sum of |amplitude|^2 over the vector, accumulated in type S (per slice, then over the slices) */
+template <typename S, typename T>
+double squaredNorm(const T *re, const T *im, long long size, workPool *pool){
+    vector<S> partial(pool ? pool->size() : 1, 0);
+    forEachSlice(pool, [&](int part, int parts){
+        S sum = 0;
+        for (long long i = size * part / parts; i < size * (part + 1) / parts; i++) sum += (S)re[i] * re[i] + (S)im[i] * im[i];
+        partial[part] = sum;
+    });
+    S norm = 0;
+    for (S sum : partial) norm += sum;
+    return norm;
+}
+
+/* reportDrift: compares an evolved vector of type T (stored in 'layout', scaled by 'scale' as reported) with the double-precision result of
+ the same plan, when that fits in memory: the error of the end amplitude, the largest error of any amplitude and the L2 error */
+template <typename T>
+void reportDrift(const T *re, const vector<int> &layout, double scale, const lazyPlan &plan, int N, int fusionQubits, int endState,
+                 bool hugePages, bool cacheBlocking, workPool *pool){
+    int active = (int)plan.activated.size();
+    long long spaceSize = 1LL << active, passCount, sweeps;
+    vector<int> exactLayout;
+    double *exactRe = evolveLazy<double>(plan, N, fusionQubits, false, hugePages, cacheBlocking, pool, exactLayout, passCount, sweeps);
+    if (exactRe == NULL){
+        cout << "Drift from double precision: not measured (no memory for a double-precision vector)\n";
+        return;
+    }
+    vector<int> bits, exactBits; //the array bits holding each activated qubit, in both vectors
+    for (int q : plan.activated) bits.push_back(layout[N - q - 1]), exactBits.push_back(exactLayout[N - q - 1]);
+    const T *im = re + spaceSize;
+    double *exactIm = exactRe + spaceSize, largest = 0, squared = 0, endError = 0;
+    long long end = storedIndex(endState, layout, plan.classical); //the classical bits (and the global phase) are exact in both
+    bool sameLayout = bits == exactBits;
+    for (long long i = 0; i < spaceSize; i++){
+        long long p = sameLayout ? i : physicalIndex(i, bits), q = sameLayout ? i : physicalIndex(i, exactBits);
+        double error = abs(complex<double>(scale * re[p] - exactRe[q], scale * im[p] - exactIm[q]));
+        largest = max(largest, error), squared += error * error;
+        if (p == end) endError = error;
+    }
+    cout << "Drift from double precision: " << endError << " at the end amplitude, " << largest << " at most, " << sqrt(squared) << " over the vector (L2)\n";
+    free(exactRe);
+}
+
+/* runPrecision: the simulation with amplitudes of type T, accumulating norms in type S */
+template <typename T, typename S>
+void runPrecision(const lazyPlan &plan, int N, int startState, int endState, bool verbose, bool hugePages, workPool *pool, int fusionQubits,
+                  bool cacheBlocking, int precision, bool precisionDrift, const shotSettings &shots, bool showRuntime, struct timeval wallStart){
+    int active = (int)plan.activated.size();
+    long long spaceSize = 1LL << active, passCount, sweeps;
+    vector<int> layout; //layout[b] = the bit of the array holding index bit b (< 0: a classical bit)
+    T *ampRe = evolveLazy<T>(plan, N, fusionQubits, verbose, hugePages, cacheBlocking, pool, layout, passCount, sweeps);
+    if (ampRe == NULL){
+        cout << "\n";
+        return;
+    }
+    T *ampIm = ampRe + spaceSize;
+    double scale = 1;
+    if (precision != DOUBLE_PRECISION){
+        double norm = squaredNorm<S>(ampRe, ampIm, spaceSize, pool);
+        cout << "Norm: " << norm << " (accumulated in " << (sizeof(S) == sizeof(double) ? "double" : "float") << ")\n";
+        if (precision == MIXED_PRECISION && norm > 0) scale = 1 / sqrt(norm); //amplitudes are reported renormalized
+    }
+    auto amplitude = [&](long long i){
+        long long p = storedIndex(i, layout, plan.classical);
+        return p < 0 ? complex<double>(0, 0) : plan.phase * complex<double>(scale * ampRe[p], scale * ampIm[p]);
+    };
+    if (verbose){
+        for (long long i = 0; i < (1LL << N); i++) cout << binString((int)i, N) << ": " << amplitude(i) << "\n";
     }
-    cout << "<" << binString(endState, N) << "|Circuit|" << binString(startState, N) << "> = " << amps[endState].real() << " + " << amps[endState].imag() << "i\n";
+    complex<double> end = amplitude(endState);
+    cout << "<" << binString(endState, N) << "|Circuit|" << binString(startState, N) << "> = " << end.real() << " + " << end.imag() << "i\n";
     
-    if (showRuntime){ //Print time usage
+    if (showRuntime){ //Print time usage (CPU time summed over all threads, and wall-clock time)
         cout.precision(7);
         struct rusage usage;
+        struct timeval wallEnd;
         getrusage(RUSAGE_SELF, &usage);
+        gettimeofday(&wallEnd, NULL);
         long totaluTime = (usage.ru_stime.tv_sec + usage.ru_utime.tv_sec) * 1000000 + usage.ru_stime.tv_usec + usage.ru_utime.tv_usec;
         double totalTime = totaluTime/ (double) 1000000;
-        cout << "Runtime: " << totalTime << " seconds\n";
+        long wall = (wallEnd.tv_sec - wallStart.tv_sec) * 1000000 + wallEnd.tv_usec - wallStart.tv_usec;
+        cout << "Runtime: " << totalTime << " seconds (" << selectKernels<T>(spaceSize).name << " kernels, " << passCount << " passes in " << sweeps << " sweeps, " << active << " of " << N << " qubits active, " << (pool ? pool->size() : 1) << " threads, wall clock " << wall / (double) 1000000 << " seconds)\n";
         //        cout << "Memory usage: " << usage.ru_maxrss / (double) memConst << " qunits [1 qunit ≈ 1 mb]\n\n";
         //Memory usage details removed due to unclear units
     }
+    if (shots.shots > 0) sampleShots(ampRe, ampIm, N, layout, plan.classical, shots, pool);
+    if (precision != DOUBLE_PRECISION && precisionDrift) reportDrift(ampRe, layout, scale, plan, N, fusionQubits, endState, hugePages, cacheBlocking, pool);
     cout << "\n";
+    free(ampRe);
+}
+
+/* First simulation algorithm: tracking entire state vector
+ Takes time T*exp(O(n)) and space exp(O(n)) [T = total # of gates]
+ 
+ The vector is stored split (real parts, then imaginary parts) and every gate is one call to the vectorized kernels of gateKernels.cpp,
+ picked for this CPU at runtime (AVX-512, AVX2 or scalar). With cacheBlocking, runs of gates are applied one L2-sized block at a time,
+ with qubits swapped into the block when a gate needs them (cacheBlocking.cpp), so a circuit takes a few sweeps over memory rather than
+ one per gate; the amplitudes then end up stored in a permuted bit order, which is undone when they are read. With lazyQubits, a qubit
+ only gets a dimension in the vector once a gate puts it in superposition (see LAZY QUBIT ACTIVATION above): until then it is a
+ classical bit, and gates on classical bits only are bit updates, so the vector is only as large as the qubits activated so far.
+ 
+ Amplitudes are doubles, or floats in single and mixed precision: half the memory (one more qubit in the same RAM) and half the bytes
+ per sweep, which is what bounds a gate's speed. Single precision reports its norm as summed in float; mixed precision sums it in
+ double and reports the amplitudes renormalized by it, removing the norm drift that float rounding accumulates over the gates.
+ 
+ PARAMETERS:
+ in: file input stream to read gates from
+ n: number of qubits
+ startState: starting state of qubit register
+ verbose: set to true to print intermediate amplitude values between each gate,
+ false to only print the end amplitudes
+ hugePages: back the amplitude array with transparent huge pages (fewer TLB misses on large vectors)
+ numThreads: threads applying each gate (<= 0: all cores), pinned to cores; every thread keeps the same slice of the vector
+ fusionQubits: consecutive gates on at most this many qubits are fused into one sweep (<= 1: no fusion; see gateFusion.cpp)
+ cacheBlocking: run the circuit block by block, as above
+ lazyQubits: keep qubits classical until they need a dimension, as above
+ precision: DOUBLE_PRECISION, SINGLE_PRECISION or MIXED_PRECISION, as above
+ precisionDrift: in single or mixed precision, also run the circuit in double precision (if it fits) and print how far the result drifted
+ shots: measurements to sample from the final vector, written as a histogram (see shotSampling.cpp)
+ 
+ MODIFIED VERBOSE: TRUE = PRINT ALL END AMPLITUDES, FALSE = ONLY PRINTS "DONE"
+ (because of very large state spaces yielding massive console outputs, verbose was adjusted from the previous definition.) */
+
+void stateVector(string gatePath, int N, int startState, int endState, bool verbose, bool hugePages, int numThreads, int fusionQubits, bool cacheBlocking,
+                 bool lazyQubits, int precision, bool precisionDrift, const shotSettings &shots, bool showRuntime){
+    cout << "Comparison algorithm: [stateVector" << (precision == SINGLE_PRECISION ? ", single precision" : precision == MIXED_PRECISION ? ", mixed precision" : "") << "]\n" << N << " qubit simulation in progress........\n";
+    struct timeval wallStart;
+    gettimeofday(&wallStart, NULL);
+    
+    unique_ptr<workPool> pool;
+    if (numThreads != 1 && N >= PARALLEL_MIN_QUBITS){
+        pool.reset(new workPool(numThreads));
+        pool->pin();
+    }
+    lazyPlan plan = planLazy(compileCircuit(gatePath, N), N, startState, lazyQubits); //gates.txt is parsed once
+    switch (precision){
+        case SINGLE_PRECISION: runPrecision<float, float>(plan, N, startState, endState, verbose, hugePages, pool.get(), fusionQubits, cacheBlocking, precision, precisionDrift, shots, showRuntime, wallStart); break;
+        case MIXED_PRECISION: runPrecision<float, double>(plan, N, startState, endState, verbose, hugePages, pool.get(), fusionQubits, cacheBlocking, precision, precisionDrift, shots, showRuntime, wallStart); break;
+        default: runPrecision<double, double>(plan, N, startState, endState, verbose, hugePages, pool.get(), fusionQubits, cacheBlocking, DOUBLE_PRECISION, false, shots, showRuntime, wallStart); break;
+    }
 }
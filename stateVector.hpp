@@ -9,6 +9,40 @@
 #ifndef stateVector_h
 #define stateVector_h
 
-void stateVector(string gatePatb, int N, int startState, int endState, bool verbose, bool showRuntime);
+#include <string>
+#include <complex>
+#include <functional>
+#include <vector>
+using namespace std;
+
+class workPool;
+struct shotSettings;
+struct fusedGate;
+template <typename T> struct basicGateKernels;
+
+#define DOUBLE_PRECISION 0 //amplitudes are complex<double>
+#define SINGLE_PRECISION 1 //amplitudes are complex<float>
+#define MIXED_PRECISION 2 //amplitudes are complex<float>, norms are accumulated in double
+
+void stateVector(string gatePatb, int N, int startState, int endState, bool verbose, bool hugePages, int numThreads, int fusionQubits, bool cacheBlocking,
+                 bool lazyQubits, int precision, bool precisionDrift, const shotSettings &shots, bool showRuntime);
+
+/* allocAmplitudes: zeroed, aligned split array of count amplitudes of type T (count real parts, then count imaginary parts; huge-page
+ backed if requested), or NULL if it exceeds the available memory. With a pool, every worker first touches its own slice. */
+template <typename T>
+T *allocAmplitudes(long long count, bool hugePages, workPool *pool);
+
+/* applyPass: applies slice 'part' of 'parts' of a pass (on physical index bits) to the size amplitudes at re, im, which are the block of
+ an N-qubit vector starting at index base; the pass may only mix bits inside the block */
+template <typename T>
+void applyPass(const basicGateKernels<T> &kernels, const fusedGate &pass, T *re, T *im, long long size, long long base, int N, int part, int parts);
+
+/* evolveVector: applies the passes (on index bits, from fuseGates) to the 2^N amplitudes at re, im, given with index bit b at bit b; the
+ result is left with index bit b at bit layout[b] (see cacheBlocking.hpp) */
+template <typename T>
+void evolveVector(const vector<fusedGate> &passes, T *re, T *im, int N, bool verbose, bool cacheBlocking, workPool *pool, vector<int> &layout, long long &sweeps);
+
+/* forEachSlice: runs slice(part, parts) once per worker of the pool (worker p runs part p), or slice(0, 1) when pool is NULL */
+void forEachSlice(workPool *pool, function<void(int, int)> slice);
 
 #endif /* stateVector_h */
@@ -0,0 +1,72 @@
+//
+//  widePath.cpp
+//  PocketSimulator
+//
+//  Created on 10/16/26.
+//  Copyright © 2017. All rights reserved.
+//
+#include <iostream>
+#include <complex>
+#include <fstream>
+#include <time.h>
+#include <sys/time.h>
+#include <sys/resource.h>
+#include <math.h>
+#define _USE_MATH_DEFINES
+
+#include "widePath.hpp"
+#include "pathIntegral.hpp"
+#include "circuit.hpp"
+using namespace std;
+
+//----------------------------WIDE-REGISTER PATH INTEGRAL SUMMING--------------------------
+
+/* The path integral needs only O(n + h) space, so its register width is limited by the basis-state type alone. The other engines keep
+ their int states (n <= MAX_INT_QUBITS); this one runs the explicit-stack sum of iterativePathIntegral on a state type S picked from n:
+ 
+ n <= 64: unsigned long long
+ n <= 128: __uint128_t
+ n <= MAX_WIDE_QUBITS: wideState (a fixed-width bitset)
+ 
+ iterativePathSum is a template over S, so each width is compiled separately and the two machine-word types run with plain integer
+ instructions; only the bit difference needs a type-specific popcount (stateTraits, in helpers.hpp). */
+
+template <typename S>
+S parseBits(string bits, int N){ //N-character bit string (qubit 0 first) --> state
+    S state = S(0);
+    for (int q = 0; q < N && q < (int)bits.length(); q++) if (bits[q] == '1') state |= S(1) << (N - q - 1);
+    return state;
+}
+
+template <typename S>
+complex<double> widePathSum(string gatePath, int N, string startBits, string endBits, long long &nodes){
+    vector<basicGateOp<S>> circuit = compileWideCircuit<S>(gatePath, N);
+    int numGates = (int)circuit.size();
+    vector<int> changesAfter(numGates + 1, 0);
+    for (int g = numGates - 1; g >= 0; g--) changesAfter[g] = changesAfter[g + 1] + (circuit[g].gate != 'p');
+    return iterativePathSum(circuit, lightConeMasks(circuit), changesAfter, parseBits<S>(startBits, N), parseBits<S>(endBits, N), nodes);
+}
+
+void widePathIntegral(string gatePath, int n, string startBits, string endBits, bool showRuntime){
+    cout << "Main Method: [PocketSimulator, wide register]\n" << n << " qubit simulation in progress........\n";
+    if (n > MAX_WIDE_QUBITS){
+        cout << "At most " << MAX_WIDE_QUBITS << " qubits are supported\n\n";
+        return;
+    }
+    long long nodes;
+    complex<double> result;
+    if (n <= 64) result = widePathSum<unsigned long long>(gatePath, n, startBits, endBits, nodes);
+    else if (n <= 128) result = widePathSum<__uint128_t>(gatePath, n, startBits, endBits, nodes);
+    else result = widePathSum<wideState>(gatePath, n, startBits, endBits, nodes);
+    cout << "<" << endBits << "|Circuit|" << startBits << "> = " << result.real() << " + " << result.imag() << "i\n";
+    
+    if (showRuntime){ //Print time usage
+        cout.precision(7);
+        struct rusage usage;
+        getrusage(RUSAGE_SELF, &usage);
+        long totaluTime = (usage.ru_stime.tv_sec + usage.ru_utime.tv_sec) * 1000000 + usage.ru_stime.tv_usec + usage.ru_utime.tv_usec;
+        double totalTime = totaluTime/ (double) 1000000;
+        cout << "Runtime: " << totalTime << " seconds (" << nodes << " nodes)\n";
+    }
+    cout << "\n";
+}
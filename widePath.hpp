@@ -0,0 +1,20 @@
+//
+//  widePath.hpp
+//  PocketSimulator
+//
+//  Created on 10/16/26.
+//  Copyright © 2017. All rights reserved.
+//
+
+#ifndef widePath_hpp
+#define widePath_hpp
+
+#include <stdio.h>
+#include <string>
+using namespace std;
+
+/* widePathIntegral: the iterative path integral for registers of up to MAX_WIDE_QUBITS qubits. The start and end states are given as
+ N-character bit strings (qubit 0 first, as printed by binString); the state type is chosen from N (see widePath.cpp). */
+void widePathIntegral(string gatePath, int N, string startBits, string endBits, bool showRuntime);
+
+#endif /* widePath_hpp */
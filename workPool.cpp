@@ -0,0 +1,126 @@
+//
+//  workPool.cpp
+//  PocketSimulator
+//
+//  Created on 10/16/26.
+//  Copyright © 2017. All rights reserved.
+//
+#include "workPool.hpp"
+#ifdef __linux__
+#include <pthread.h>
+#include <sched.h>
+#endif
+using namespace std;
+
+workPool::workPool(int numThreads) : queued(0), pending(0), stopping(false), nextQueue(0){
+    if (numThreads <= 0) numThreads = max(1, (int)thread::hardware_concurrency());
+    for (int i = 0; i < numThreads; i++) queues.push_back(unique_ptr<workQueue>(new workQueue()));
+    for (int i = 0; i < numThreads; i++) workers.push_back(thread(&workPool::workerLoop, this, i));
+}
+
+workPool::~workPool(){
+    {
+        lock_guard<mutex> guard(idleLock);
+        stopping = true;
+    }
+    idle.notify_all();
+    for (thread &worker : workers) worker.join();
+}
+
+void workPool::submit(function<void(int)> task){
+    pending++;
+    {
+        workQueue &queue = *queues[nextQueue];
+        lock_guard<mutex> guard(queue.lock);
+        queue.tasks.push_back(move(task));
+    }
+    nextQueue = (nextQueue + 1) % size();
+    {
+        lock_guard<mutex> guard(idleLock);
+        queued++;
+    }
+    idle.notify_one();
+}
+
+void workPool::submitTo(int worker, function<void(int)> task){
+    pending++;
+    workQueue &queue = *queues[worker % size()];
+    {
+        lock_guard<mutex> guard(queue.lock);
+        queue.pinned.push_back(move(task));
+    }
+    {
+        lock_guard<mutex> guard(idleLock);
+        queue.pinnedCount++;
+    }
+    idle.notify_all(); //the owner has to wake, whichever worker notify_one would pick
+}
+
+void workPool::pin(){
+#ifdef __linux__
+    cpu_set_t allowed;
+    if (sched_getaffinity(0, sizeof(allowed), &allowed) != 0) return;
+    vector<int> cores;
+    for (int c = 0; c < CPU_SETSIZE; c++) if (CPU_ISSET(c, &allowed)) cores.push_back(c);
+    for (int i = 0; i < size() && !cores.empty(); i++){
+        cpu_set_t core;
+        CPU_ZERO(&core);
+        CPU_SET(cores[i % cores.size()], &core);
+        pthread_setaffinity_np(workers[i].native_handle(), sizeof(core), &core);
+    }
+#endif
+}
+
+void workPool::wait(){
+    unique_lock<mutex> lock(idleLock);
+    done.wait(lock, [this]{ return pending == 0; });
+}
+
+bool workPool::popTask(int id, function<void(int)> &task){
+    { //tasks pinned to this worker, then the newest task from its own deque
+        workQueue &own = *queues[id];
+        lock_guard<mutex> guard(own.lock);
+        if (!own.pinned.empty()){
+            task = move(own.pinned.front());
+            own.pinned.pop_front();
+            own.pinnedCount--;
+            return true;
+        }
+        if (!own.tasks.empty()){
+            task = move(own.tasks.back());
+            own.tasks.pop_back();
+            queued--;
+            return true;
+        }
+    }
+    for (int i = 1; i < size(); i++){ //otherwise steal the oldest task of another worker
+        workQueue &victim = *queues[(id + i) % size()];
+        lock_guard<mutex> guard(victim.lock);
+        if (!victim.tasks.empty()){
+            task = move(victim.tasks.front());
+            victim.tasks.pop_front();
+            queued--;
+            return true;
+        }
+    }
+    return false;
+}
+
+void workPool::workerLoop(int id){
+    function<void(int)> task;
+    while (true){
+        if (popTask(id, task)){
+            task(id);
+            task = nullptr;
+            if (--pending == 0){
+                { lock_guard<mutex> guard(idleLock); }
+                done.notify_all();
+            }
+            continue;
+        }
+        unique_lock<mutex> lock(idleLock);
+        workQueue &own = *queues[id];
+        idle.wait(lock, [this, &own]{ return stopping || queued > 0 || own.pinnedCount > 0; });
+        if (stopping && queued == 0 && own.pinnedCount == 0) return;
+    }
+}
@@ -0,0 +1,59 @@
+//
+//  workPool.hpp
+//  PocketSimulator
+//
+//  Created on 10/16/26.
+//  Copyright © 2017. All rights reserved.
+//
+
+#ifndef workPool_hpp
+#define workPool_hpp
+
+#include <stdio.h>
+#include <vector>
+#include <deque>
+#include <memory>
+#include <thread>
+#include <mutex>
+#include <atomic>
+#include <functional>
+#include <condition_variable>
+using namespace std;
+
+/* workPool: a fixed-size work-stealing thread pool.
+ Every worker owns a task deque: it pops its own work from the back and, once empty, steals from the front of the other workers' deques.
+ Tasks receive the id (0 to size() - 1) of the worker running them so that callers can keep per-thread state and partial results.
+ Tasks given to submitTo are never stolen, so a caller can keep a fixed piece of data on the same worker (and, once pinned, the same core). */
+class workPool {
+public:
+    workPool(int numThreads); //numThreads <= 0 uses every hardware thread
+    ~workPool();
+    
+    void submit(function<void(int)> task); //queue a task (round-robin over the worker deques)
+    void submitTo(int worker, function<void(int)> task); //queue a task that only the given worker may run
+    void wait(); //block until every submitted task has finished
+    void pin(); //pin worker i to the i-th core this process may run on (Linux; a no-op elsewhere)
+    int size() { return (int)queues.size(); } //queues is complete before any worker starts (workers grows while they run)
+    
+private:
+    struct workQueue {
+        mutex lock;
+        deque<function<void(int)>> tasks;
+        deque<function<void(int)>> pinned; //submitTo tasks: run by this worker only
+        atomic<int> pinnedCount;
+        workQueue() : pinnedCount(0) {}
+    };
+    
+    vector<thread> workers;
+    vector<unique_ptr<workQueue>> queues;
+    atomic<int> queued, pending; //tasks waiting in deques / tasks not yet finished
+    atomic<bool> stopping;
+    int nextQueue;
+    mutex idleLock;
+    condition_variable idle, done;
+    
+    bool popTask(int id, function<void(int)> &task); //pinned tasks, own deque, then steal
+    void workerLoop(int id);
+};
+
+#endif /* workPool_hpp */